@@ -0,0 +1,70 @@
+#include "uv_coro.h"
+
+#define DEFAULT_ROUNDS 10000
+/* large enough that most writes outrun the socket buffer and get queued */
+#define WRITE_SIZE Kb(256)
+
+static double bench_fs(string_t path, int rounds) {
+    uint64_t start = uv_hrtime();
+    int i;
+    for (i = 0; i < rounds; i++) {
+        uv_file fd = fs_open(path, O_RDONLY, 0);
+        fs_fstat(fd);
+        fs_close(fd);
+    }
+
+    return (double)(uv_hrtime() - start) / (rounds * 3);
+}
+
+static void_t drain(params_t args) {
+    uv_stream_t *reader = (uv_stream_t *)args[0].object;
+    size_t total = args[1].max_size, got = 0;
+    char buf[Kb(64)];
+    ssize_t nread;
+
+    while (got < total && (nread = stream_read_into(reader, buf, sizeof(buf))) > 0)
+        got += (size_t)nread;
+
+    return 0;
+}
+
+static double bench_write(string data, int rounds) {
+    socketpair_t *pair = socketpair_create(AF_UNIX, 0);
+    uint64_t start = uv_hrtime();
+    rid_t drained;
+    int i;
+
+    drained = go(drain, 2, pair->reader, (size_t)rounds * WRITE_SIZE);
+    for (i = 0; i < rounds; i++)
+        stream_write_buf((uv_stream_t *)pair->writer, data, WRITE_SIZE);
+
+    while (!result_is_ready(drained))
+        yield();
+
+    return (double)(uv_hrtime() - start) / rounds;
+}
+
+int uv_main(int argc, char **argv) {
+    int rounds = argc > 1 && atoi(argv[1]) > 10 ? atoi(argv[1]) : DEFAULT_ROUNDS;
+    string data = try_calloc(1, WRITE_SIZE);
+    double awaited, direct;
+
+    uv_coro_direct_set(false);
+    awaited = bench_fs(__FILE__, rounds);
+    uv_coro_direct_set(true);
+    direct = bench_fs(__FILE__, rounds);
+
+    printf("fs ops x %d: awaited %.0f ns/op, direct %.0f ns/op, %.1f%% saved\n",
+           rounds * 3, awaited, direct, (awaited - direct) * 100.0 / awaited);
+
+    uv_coro_direct_set(false);
+    awaited = bench_write(data, rounds / 10);
+    uv_coro_direct_set(true);
+    direct = bench_write(data, rounds / 10);
+
+    printf("stream writes x %d: awaited %.0f ns/op, direct %.0f ns/op, %.1f%% saved\n",
+           rounds / 10, awaited, direct, (awaited - direct) * 100.0 / awaited);
+
+    RAII_FREE(data);
+    return 0;
+}
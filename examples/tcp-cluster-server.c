@@ -0,0 +1,20 @@
+#include "uv_coro.h"
+
+#define DEFAULT_PORT 7000
+
+void new_connection(uv_stream_t *socket) {
+    string data = stream_read(socket);
+    stream_write(socket, data);
+}
+
+int uv_main(int argc, char **argv) {
+    char addr[UV_MAXHOSTNAMESIZE] = nil;
+    int threads = argc > 1 ? atoi(argv[1]) : 0;
+
+    if (snprintf(addr, sizeof(addr), "0.0.0.0:%d", DEFAULT_PORT)) {
+        if (stream_bind_cluster(addr, threads, new_connection) < 0)
+            fprintf(stderr, "Cluster error %s\n", uv_strerror(coro_err_code()));
+    }
+
+    return coro_err_code();
+}
@@ -68,6 +68,13 @@ typedef enum {
     UV_CORO_TTY_1,
     UV_CORO_TTY_2,
     UV_CORO_LISTEN = UV_CORO_TTY_2 + UV_HANDLE_TYPE_MAX,
+    UV_CORO_READER,
+    UV_CORO_CORK,
+    UV_CORO_FS,
+    UV_CORO_FS_READER,
+    UV_CORO_MMAP,
+    UV_CORO_FS_BATCH,
+    UV_CORO_TASK,
     UV_CORO_ARGS
 } uv_coro_types;
 
@@ -146,6 +153,15 @@ typedef struct {
 } tty_err_t;
 
 typedef struct udp_packet_s udp_packet_t;
+typedef struct stream_reader_s stream_reader_t;
+typedef struct stream_cork_s stream_cork_t;
+typedef struct stream_into_s stream_into_t;
+typedef struct accept_queue_s accept_queue_t;
+typedef struct select_slot_s select_slot_t;
+typedef struct fs_reader_s fs_reader_t;
+typedef struct fs_batch_s fs_batch_t;
+/* `fd` of `fs_batch_*()` operations chained to the file opened by the latest `fs_batch_open()`. */
+#define FS_BATCH_FD (-2)
 typedef struct addrinfo addrinfo_t;
 typedef const struct sockaddr sockaddr_t;
 typedef struct sockaddr_in sock_in_t;
@@ -196,13 +212,66 @@ typedef struct dnsinfo_s {
     char ip[INET6_ADDRSTRLEN + 1];
 } dnsinfo_t;
 
+typedef enum {
+    /* `fdatasync()` before closing */
+    FS_WRITE_SYNC = 1,
+    /* write a synced temporary file next to `path`, then rename it over `path` */
+    FS_WRITE_ATOMIC = 2
+} fs_write_flags;
+
+typedef enum {
+    FS_MMAP_SEQUENTIAL = 1,
+    FS_MMAP_RANDOM = 2,
+    FS_MMAP_WILLNEED = 4,
+    /* touch every page before handing the mapping back */
+    FS_MMAP_PREFAULT = 8
+} fs_mmap_flags;
+
+typedef struct fs_mmap_s {
+    uv_coro_types type;
+    int status;
+    /* read only view of the whole file, `NULL` when empty */
+    string_t data;
+    size_t length;
+} fs_mmap_t;
+
+typedef struct bufpool_stats_s {
+    /* requests served from an idle buffer */
+    size_t hits;
+    /* requests that needed a fresh allocation */
+    size_t misses;
+    /* idle buffers currently held by the pool */
+    size_t cached;
+} bufpool_stats_t;
+
+typedef struct stream_selected_s {
+    /* position in the handle set of the first one with data */
+    int index;
+    /* bytes read, `UV_EOF`, `UV_ETIMEDOUT` or error code */
+    ssize_t nread;
+    /* data read, null terminated */
+    string data;
+    /* set when selected handle is an `uv_udp_t`, as `udp_recv()` would return it */
+    udp_packet_t *packet;
+} stream_selected_t;
+
+typedef enum {
+    /* poll the loop without blocking on every scheduler pass */
+    UV_CORO_RUN_NOWAIT,
+    /* block in `UV_RUN_ONCE` as soon as a pass finds no I/O or timers to handle */
+    UV_CORO_RUN_BLOCK,
+    /* keep polling for a number of idle passes, then block */
+    UV_CORO_RUN_ADAPTIVE
+} uv_coro_run_mode;
+
 typedef struct uv_args_s {
     uv_coro_types type;
     raii_type bind_type;
-    bool is_path;
     bool is_request;
     bool is_freeable;
     bool is_server;
+    /* waiting coroutine gone, threadpool callback only releases resources */
+    bool is_abandoned;
     uv_fs_type fs_type;
     uv_req_type req_type;
     uv_handle_type handle_type;
@@ -217,10 +286,29 @@ typedef struct uv_args_s {
     evt_ctx_t ctx;
     string buffer;
     uv_buf_t bufs;
+
+    /* scatter-gather set for `stream_writev()` */
+    uv_buf_t *vbufs;
+    unsigned int nbufs;
+
+    /* state of `stream_read_into()`, set by its first call */
+    stream_into_t *into;
+
+    /* connection owned ring buffer, set by `stream_buffered()` */
+    stream_reader_t *reader;
+
+    /* output buffer collecting small writes, set by `stream_cork()` */
+    stream_cork_t *cork;
+
+    /* clients accepted ahead of `stream_listen()`, set by `stream_bind_ex()` */
+    accept_queue_t *accepts;
+
+    /* deadline armed for the current await, if any */
+    void_t expiry;
+
+    /* `stream_select()` entry this handle is armed for */
+    select_slot_t *select;
     uv_fs_t req;
-    uv_stat_t stat[1];
-    uv_statfs_t statfs[1];
-    scandir_t dir[1];
     dnsinfo_t dns[1];
 } uv_args_t;
 
@@ -327,14 +415,79 @@ C_API uv_stream_t *ipc_in(spawn_t);
 C_API uv_stream_t *ipc_out(spawn_t);
 C_API uv_stream_t *ipc_err(spawn_t);
 
+/* Run `fn` with `n_args` pointer sized arguments on the libuv threadpool, resuming
+caller with its result. `fn` runs on another thread, it must not touch coroutines,
+the loop, or caller scoped memory that could go away. Arguments are copied into the
+request as `args[0]` .. `args[n_args - 1]`, no `$size()`. Still queued work is canceled
+if caller is halted or its deadline passes, running work finishes unobserved. */
+C_API value_t queue_work(callable_t fn, size_t n_args, ...);
+
+/* Whole file in one threadpool job, freed when calling coroutine returns. */
 C_API string fs_readfile(string_t path);
+
+/* Create or truncate `path` with `text`, one threadpool job, returns bytes written. */
 C_API int fs_writefile(string_t path, string_t text);
 
+/* Write `length` bytes of `data` to `path` in one threadpool job, `flags` of `fs_write_flags`.
+The job writes a copy of `data`, it can outlive a caller giving up on it. Returns bytes
+written, or error code. */
+C_API int fs_writefile_buf(string_t path, string_t data, size_t length, int flags);
+
 C_API uv_file fs_open(string_t path, int flags, int mode);
 C_API int fs_close(uv_file fd);
 C_API uv_stat_t *fs_fstat(uv_file fd);
 C_API string fs_read(uv_file fd, int64_t offset);
 C_API int fs_write(uv_file fd, string_t text, int64_t offset);
+
+/* Scatter/gather versions, all `n` buffers go straight through a single `preadv()`/`pwritev()`,
+sizes taken from each `len`, nothing is copied. Offset `-1` uses current file position.
+Returns bytes transferred, or negative error code. */
+C_API ssize_t fs_readv(uv_file fd, uv_buf_t bufs[], unsigned int n, int64_t offset);
+C_API ssize_t fs_writev(uv_file fd, const uv_buf_t bufs[], unsigned int n, int64_t offset);
+
+/* Map whole file at `path` read only, `flags` of `fs_mmap_flags` become `madvise()` hints.
+Opening, mapping and any prefaulting run on the threadpool, so page faults never stall
+the loop. Unmapped when calling coroutine returns. */
+C_API fs_mmap_t *fs_mmap(string_t path, int flags);
+
+/* Read `fd` from its current position in `chunk_size` pieces, 0 uses 64Kb, through two
+fixed buffers, the next chunk is read while the caller works on the current one.
+Released when calling coroutine returns. */
+C_API fs_reader_t *fs_reader(uv_file fd, size_t chunk_size);
+
+/* Point `chunk` at the next piece, valid until the following call.
+Returns its length, 0 at end of file, or error code. */
+C_API ssize_t fs_reader_next(fs_reader_t *, string_t *chunk);
+
+/* Collect many open/stat/read/write/close operations to submit and await together,
+through io_uring on Linux, otherwise in shared threadpool jobs. Operations given
+`FS_BATCH_FD` run in order on the file of the `fs_batch_open()` before them, which is
+closed when the chain ends, everything else runs in any order.
+Released, with all read buffers, when calling coroutine returns. */
+C_API fs_batch_t *fs_batch(void);
+
+/* Queue an operation, returns its index, or error code.
+Paths and written data are copied into the batch, so operations still running past
+a deadline never touch caller memory. */
+C_API int fs_batch_open(fs_batch_t *, string_t path, int flags, int mode);
+C_API int fs_batch_stat(fs_batch_t *, string_t path);
+C_API int fs_batch_read(fs_batch_t *, uv_file fd, size_t size, int64_t offset);
+C_API int fs_batch_write(fs_batch_t *, uv_file fd, string_t data, size_t size, int64_t offset);
+C_API int fs_batch_close(fs_batch_t *, uv_file fd);
+
+/* Open, read up to `max_size` bytes, and close `path` as one chain, returns index of the read. */
+C_API int fs_batch_readfile(fs_batch_t *, string_t path, size_t max_size);
+
+/* Submit everything queued and wait for all of it, once per batch.
+Returns 0, or error code when the batch could not finish, like a passed deadline. */
+C_API int fs_batch_await(fs_batch_t *);
+
+/* Bytes transferred, descriptor opened, or 0, error code when that operation failed,
+`UV_ECANCELED` for chained operations after their `open` failed. */
+C_API ssize_t fs_batch_result(fs_batch_t *, int index);
+
+/* Buffer of a read, or `uv_stat_t` of a stat, `NULL` otherwise. */
+C_API void_t fs_batch_data(fs_batch_t *, int index);
 C_API int fs_fsync(uv_file fd);
 C_API int fs_fdatasync(uv_file fd);
 C_API int fs_ftruncate(uv_file fd, int64_t offset);
@@ -396,6 +549,54 @@ C_API string stream_read(uv_stream_t *);
 C_API int stream_write(uv_stream_t *, string_t text);
 C_API int stream_shutdown(uv_stream_t *);
 
+/* Binary safe read, fills caller `buf` up to `cap` bytes, no allocation.
+Returns number of bytes read, `UV_EOF` or negative error code. */
+C_API ssize_t stream_read_into(uv_stream_t *, void_t buf, size_t cap);
+
+/* Binary safe write of exactly `len` bytes from `data`. */
+C_API int stream_write_buf(uv_stream_t *, const void *data, size_t len);
+
+/* Switch stream into buffered reader mode, reading stays armed and data lands
+in a ring buffer owned by the connection, growing up to `max_size` bytes,
+before reading is paused. `stream_read` variants then consume from it directly.
+Released when calling coroutine returns. */
+C_API int stream_buffered(uv_stream_t *, size_t max_size);
+
+/* Write all `n` buffers with a single `uv_write()`, one writev syscall. */
+C_API int stream_writev(uv_stream_t *, uv_buf_t *bufs, size_t n);
+
+/* Collect subsequent small writes into a connection output buffer,
+sent as one write on `stream_uncork()` or once 16Kb is buffered.
+Released when calling coroutine returns. */
+C_API int stream_cork(uv_stream_t *);
+
+/* Send any corked output and stop buffering writes. */
+C_API int stream_uncork(uv_stream_t *);
+
+/* Like `stream_cork()`, but buffered output is also sent once per loop
+iteration, right before polling for I/O, or when `threshold` bytes are buffered. */
+C_API int stream_autocork(uv_stream_t *, size_t threshold);
+
+/* Send `len` bytes of `file` starting at `offset` straight from the kernel, `len` of 0
+sends through end of file. Waits on socket writability between partial sends.
+Returns bytes sent, or error code. */
+C_API ssize_t stream_sendfile(uv_stream_t *, uv_file file, int64_t offset, size_t len);
+
+/* Arm reads on `n` stream or `uv_udp_t` handles, resuming with the first to get data,
+reading stops on all others. Result stays valid until the next call from the same coroutine.
+Returns `NULL` with `UV_ETIMEDOUT` as error code once `timeout` milliseconds pass, 0 waits
+forever, or with the error of a handle that could not be armed, TLS and `stream_buffered()`
+streams are not supported. */
+C_API stream_selected_t *stream_select(void_t handles[], int n, u32 timeout);
+
+/* Like `stream_read()`, but gives up after `ms` milliseconds,
+returning `NULL` with `UV_ETIMEDOUT` as error code. */
+C_API string stream_read_timeout(uv_stream_t *, u32 ms);
+
+/* Like `stream_connect()`, but closes the pending connection after `ms` milliseconds,
+returning `NULL` with `UV_ETIMEDOUT` as error code. */
+C_API uv_stream_t *stream_connect_timeout(string_t address, u32 ms);
+
 C_API uv_stream_t *stream_connect(string_t address);
 C_API uv_stream_t *stream_connect_ex(uv_handle_type scheme, string_t address, int port);
 C_API uv_stream_t *stream_listen(uv_stream_t *, int backlog);
@@ -403,12 +604,41 @@ C_API uv_stream_t *stream_bind(string_t address, int flags);
 C_API uv_stream_t *stream_bind_ex(uv_handle_type scheme, string_t address, int port, int flags);
 C_API void stream_handler(stream_cb connected, uv_stream_t *client);
 
+/* Like `stream_handler()`, but `connected` runs on a coroutine with `stack_size` bytes
+of stack, rounded up to a power of two size class from 16Kb to 8Mb, larger sizes are
+used as given. A finished client's coroutine parks, up to 16 per class, and serves the
+next client of its class on the same stack. 0 uses the default 64Kb. Coroutines started
+afterwards get the stack size in effect before. Each client is served as under
+`uv_coro_pool()`, state to release with it goes in `uv_coro_scope()`. */
+C_API void stream_handler_ex(stream_cb connected, uv_stream_t *client, u32 stack_size);
+
+/* Next client already accepted during the last connection burst,
+without waiting, `NULL` once drained. */
+C_API uv_stream_t *stream_accepted(uv_stream_t *server);
+
+/* Wait for connections, then hand every client pending on `server` to
+`stream_handler(connected, client)`. Returns number dispatched, or error code. */
+C_API int stream_accept_all(uv_stream_t *server, int backlog, stream_cb connected);
+
+/* Serve `address` from `nthreads` threads, defaults to CPU count, each running its own
+loop and coroutine scheduler with an `SO_REUSEPORT` listener, dispatching clients
+to `stream_handler(connected, client)`. Calling coroutine serves as the first.
+Returns once every listener stops, on error or `stream_cluster_stop()`, with first error code. */
+C_API int stream_bind_cluster(string_t address, int nthreads, stream_cb connected);
+
+/* Stops every `stream_bind_cluster()` listener, from any thread or coroutine,
+clients already accepted are still dispatched. Returns `UV_EINVAL` if none running. */
+C_API int stream_cluster_stop(void);
+
 C_API uv_udp_t *udp_create(void);
 C_API uv_udp_t *udp_bind(string_t address, unsigned int flags);
 C_API uv_udp_t *udp_broadcast(string_t broadcast);
 C_API udp_packet_t *udp_listen(uv_udp_t *);
 C_API void udp_handler(packet_cb connected, udp_packet_t *);
 
+/* Like `udp_handler()`, with `stack_size` as in `stream_handler_ex()`. */
+C_API void udp_handler_ex(packet_cb connected, udp_packet_t *, u32 stack_size);
+
 C_API string_t udp_get_message(udp_packet_t *);
 C_API unsigned int udp_get_flags(udp_packet_t *);
 
@@ -429,6 +659,68 @@ C_API int udp_send_packet(udp_packet_t *, string_t);
 
 C_API uv_loop_t *uv_coro_loop(void);
 
+/* Read buffer of at least `size` bytes from the current loop's pool, contents are ~not~ zeroed.
+The usable size is stored in `capacity`, give back with `bufpool_put()`, which
+returns it to the pool of the calling thread's loop. */
+C_API string bufpool_get(size_t size, size_t *capacity);
+C_API void bufpool_put(void_t buffer);
+
+/* Hit and miss counters of the current loop's read buffer pool. */
+C_API bufpool_stats_t bufpool_stats(void);
+
+/* Submit fs requests and stream writes straight from the calling coroutine, which
+then parks off the run queue until the callback resumes it, instead of handing the
+request to an `uv_init()` style helper. On by default. */
+C_API void uv_coro_direct_set(bool enable);
+
+/* Let `fs_batch()` go through a per loop io_uring where the kernel supports it, off sends
+every batch to the threadpool. On by default. */
+C_API void uv_coro_uring_set(bool enable);
+
+/* Fail any stream read or write, connect, poll, `udp_recv()`, dns lookup or fs request
+the calling coroutine awaits with `UV_ETIMEDOUT` once `ms` milliseconds from now pass,
+0 clears it. A stream write queued under it gets its own copy of the data, past it
+only that write fails, the data still goes out in order and the stream stays usable.
+An fs read or write still queued is taken back,
+one already running on caller buffers is waited for, as the kernel holds them.
+Ends when calling coroutine returns. */
+C_API void uv_coro_deadline(u32 ms);
+
+/* Select how the scheduler waits on the event loop, `spins` idle passes are polled
+before blocking in `UV_RUN_ONCE` under `UV_CORO_RUN_ADAPTIVE`. Passes count as idle
+from loop activity alone, the run queue is out of sight of the loop, so a block lasts
+at most `max_block` milliseconds, which coroutines yielding in compute loops wait at
+worst. Blocking modes require a nonzero `max_block`, returns `UV_EINVAL` otherwise.
+Defaults to `UV_CORO_RUN_NOWAIT`. */
+C_API int uv_coro_run_set(uv_coro_run_mode mode, u32 spins, u32 max_block);
+
+/* Hand clients of `stream_handler()` and `udp_handler()` on this loop to `workers`
+long lived coroutines, instead of a new coroutine each. Once `max_pending` clients
+wait for a free worker, handing over parks until one frees up, pausing further
+accepts and receives. 0 workers winds the pool down, clients still queued get a
+coroutine each. Every client gets a scope of its own, released along with the client
+once its handler returns, `defer()` and `calloc_local()` in the handler stay with the
+worker coroutine until it ends, use `uv_coro_scope()` for per client state. */
+C_API int uv_coro_pool(u32 workers, u32 max_pending);
+
+/* Scope of the client the calling coroutine serves, see `uv_coro_pool()`,
+otherwise the calling coroutine's own. */
+C_API memory_t *uv_coro_scope(void);
+
+/* Start `nthreads` worker threads, each running its own loop and coroutine scheduler,
+0 uses one per cpu core. Meant as a setup option at the top of `uv_main()`, workers
+still up once it returns are stopped after their tasks finish. */
+C_API int uv_coro_workers(int nthreads);
+
+/* Run `fn` with `n_args` pointer sized arguments as a coroutine on a worker thread.
+Tasks queue on the calling worker, or a shared queue when called from outside one,
+and idle workers steal them before they start. Once started a task stays on that
+worker's loop, along with any handles it creates. */
+C_API int uv_coro_task(callable_t fn, size_t n_args, ...);
+
+/* Wait for every queued and running task to finish, then stop worker threads. */
+C_API int uv_coro_workers_stop(void);
+
 /* For displaying Cpu core count, library version, and OS system info from `uv_os_uname()`. */
 C_API string_t uv_coro_uname(void);
 C_API string_t uv_coro_hostname(void);
@@ -53,6 +53,10 @@ int uv_tls_read(uv_tls_t *tls, uv_tls_read_cb on_read);
 int uv_tls_close(uv_tls_t* session, uv_tls_close_cb close_cb);
 int uv_tls_write(uv_tls_t *stream, uv_buf_t *buf, uv_tls_write_cb cb);
 
+//encrypts the whole set of buffers in one pass, small buffers gathered into
+//full sized records, `cb` is called once
+int uv_tls_writev(uv_tls_t *stream, uv_buf_t bufs[], unsigned int nbufs, uv_tls_write_cb cb);
+
 #ifdef __cplusplus
 }
 #endif //extern C
@@ -1,4 +1,23 @@
 #include "uv_coro.h"
+#include <limits.h>
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+    #if defined(__has_include)
+        #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h>
+        #endif
+    #endif
+    /* direct descriptors, `IORING_OP_OPENAT`/`IORING_OP_CLOSE` on registered file slots */
+    #if defined(IORING_FILE_INDEX_ALLOC)
+        #define UV_CORO_URING 1
+        #include <linux/stat.h>
+        #include <sys/syscall.h>
+        #include <sys/sysmacros.h>
+    #endif
+#endif
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+#endif
 
 struct udp_packet_s {
     uv_coro_types type;
@@ -11,6 +30,441 @@ struct udp_packet_s {
     uv_udp_send_t req[1];
 };
 
+/* Read buffer size classes, 4Kb doubling to 64Kb. */
+#define BUFPOOL_CLASSES 5
+#define BUFPOOL_SMALLEST Kb(4)
+
+/* Idle buffers kept per size class before returning memory to allocator. */
+#define BUFPOOL_IDLE_MAX 64
+
+typedef struct buffer_s buffer_t;
+typedef struct loop_data_s loop_data_t;
+struct buffer_s {
+    buffer_t *next;
+    size_t size_class;
+    size_t capacity;
+};
+
+/* Idle fs requests kept per loop for reuse. */
+#define FSREQ_IDLE_MAX 64
+
+typedef struct fs_req_s fs_req_t;
+/* Per operation fs request, only what `uv_fs_*` needs. */
+struct fs_req_s {
+    uv_coro_types type;
+    uv_fs_type fs_type;
+    fs_req_t *next;
+    routine_t *context;
+    string_t path;
+    string_t new_path;
+    uv_file fd;
+    uv_file in_fd;
+    int flags;
+    int mode;
+    uv_uid_t uid;
+    uv_gid_t gid;
+    int64_t offset;
+    size_t length;
+    double atime;
+    double mtime;
+    /* caller scoped copy of stat/statfs results */
+    void_t result;
+    /* completion, when submitted straight from the calling coroutine */
+    bool is_direct;
+    bool is_done;
+    /* waiting coroutine gone or timed out, `fs_cb` only releases the request */
+    bool is_abandoned;
+    struct wheel_entry_s *expiry;
+    ssize_t status;
+    void_t data;
+    uv_buf_t bufs;
+    /* caller owned buffers of `fs_readv()`/`fs_writev()`, nothing to free */
+    const uv_buf_t *vbufs;
+    unsigned int nbufs;
+    /* milliseconds left on caller's deadline, armed by `fs_init()` */
+    u32 timeout;
+    scandir_t dir[1];
+    uv_fs_t req;
+};
+
+/* Timer wheel, 4 levels of 64 slots at 1ms resolution, about 4.6 hours span
+before entries get re-cascaded from the top level. */
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+typedef struct wheel_entry_s wheel_entry_t;
+typedef void (*wheel_cb)(wheel_entry_t *);
+struct wheel_entry_s {
+    wheel_entry_t *next;
+    wheel_entry_t **pprev;
+    uint64_t expires;
+    wheel_cb fired;
+    void_t data;
+};
+
+/* Client waiting for a pooled worker. */
+typedef struct pool_job_s {
+    bool is_udp;
+    void_t client;
+    void_t serve;
+} pool_job_t;
+
+/* Coroutine parked on a pool, linked through its own stack frame, see `pool_wait()`. */
+typedef struct pool_waiter_s {
+    routine_t *co;
+    struct pool_waiter_s *next;
+} pool_waiter_t;
+
+typedef struct worker_pool_s {
+    bool is_closing;
+    u32 workers;
+    u32 pending;
+    u32 capacity;
+    u32 head;
+    pool_job_t *jobs;
+    /* workers with nothing to do, and handlers waiting for room in `jobs` */
+    pool_waiter_t *sleepers;
+    pool_waiter_t *blocked;
+} worker_pool_t;
+
+/* Handler stack classes, 16Kb to 8Mb, and finished coroutines each keeps parked. */
+#define STACK_CLASSES 10
+#define STACK_IDLE_MAX 16
+
+/* Handler coroutine parked on its stack class, linked through its own stack frame,
+see `stack_worker()`. */
+typedef struct stack_slot_s {
+    routine_t *co;
+    pool_job_t job;
+    struct stack_slot_s *next;
+} stack_slot_t;
+
+/* Client a new `stack_worker()` starts with, and its stack class. */
+typedef struct stack_job_s {
+    pool_job_t job;
+    size_t index;
+} stack_job_t;
+
+/* Per loop state, attached as `uv_loop_t` data. */
+struct loop_data_s {
+    buffer_t *idle[BUFPOOL_CLASSES];
+    size_t idle_count[BUFPOOL_CLASSES];
+    bufpool_stats_t stats;
+    fs_req_t *fs_idle;
+    size_t fs_idle_count;
+    /* autocorked streams with output waiting for the next loop iteration */
+    stream_cork_t *corked;
+    uv_prepare_t *corker;
+    /* single libuv timer driving every sleep and deadline on this loop */
+    uv_timer_t *ticker;
+    uint64_t wheel_now;
+    uint64_t wheel_armed;
+    uint64_t wheel_fired;
+    size_t wheel_count;
+    wheel_entry_t *wheel_idle;
+    wheel_entry_t *wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    /* long lived handler coroutines, set by `uv_coro_pool()` */
+    worker_pool_t *pool;
+    /* finished `stream_handler_ex()` coroutines by stack class, and the stack size
+    last handed to `coro_stacksize_set()`, 0 for `uv_coro_stack_size` */
+    bool is_stacks_closed;
+    u32 stacks_idle[STACK_CLASSES];
+    stack_slot_t *stacks[STACK_CLASSES];
+    u32 stack_size;
+    /* bounds a blocking `UV_RUN_ONCE`, and progress seen by the previous pass */
+    uv_timer_t *waker;
+    uint64_t events;
+    uint64_t wakeups;
+    u32 idle_passes;
+    /* io_uring behind `fs_batch()`, status 0 until first tried, negative when unavailable */
+    struct uring_s *uring;
+    int uring_status;
+};
+
+struct stream_reader_s {
+    uv_coro_types type;
+    bool is_waiting;
+    bool is_paused;
+    int status;
+    size_t head;
+    size_t length;
+    size_t capacity;
+    size_t max_size;
+    uv_stream_t *handle;
+    string data;
+};
+
+/* Caller buffer `stream_read_into()` is filling, and decrypted bytes it could not take. */
+struct stream_into_s {
+    uv_buf_t buf;
+    string pending;
+    size_t pending_len;
+    size_t pending_cap;
+    uv_stream_t *handle;
+};
+
+/* Clients accepted while no `stream_listen()` was waiting, chained through handle data. */
+struct accept_queue_s {
+    bool is_accepting;
+    size_t count;
+    uv_stream_t *head;
+    uv_stream_t *tail;
+    void_t spare;
+};
+
+/* Double buffered file reader, `ahead` reads into the buffer not handed out. */
+struct fs_reader_s {
+    uv_coro_types type;
+    uv_file fd;
+    int status;
+    int current;
+    size_t chunk_size;
+    fs_req_t *ahead;
+    string buffers[2];
+};
+
+/* Unchained `fs_batch()` operations share a threadpool job in runs of this many,
+when io_uring is not available. */
+#define FS_BATCH_GROUP 16
+#if defined(UV_CORO_URING)
+    /* io_uring `statx` result kept after the `uv_stat_t` it is converted into */
+    #define FS_BATCH_STAT_SIZE (sizeof(uv_stat_t) + sizeof(struct statx))
+#else
+    #define FS_BATCH_STAT_SIZE sizeof(uv_stat_t)
+#endif
+
+typedef struct fs_batch_op_s {
+    fs_batch_t *batch;
+    uv_fs_type fs_type;
+    /* index of the `open` this operation is chained to, or -1 */
+    int head;
+    /* `open` with operations chained to it */
+    bool is_head;
+    bool is_done;
+    uv_file fd;
+    int flags;
+    int mode;
+    /* registered file slot holding the chain's file on io_uring */
+    int slot;
+    string_t path;
+    int64_t offset;
+    uv_buf_t buf;
+    uv_stat_t *stat;
+    ssize_t result;
+    /* batch owned copy of the path or written data, operations can outlive their caller */
+    string copy;
+} fs_batch_op_t;
+
+/* A chain, or run of unchained operations, done back to back on one threadpool thread. */
+typedef struct fs_batch_unit_s {
+    uv_loop_t *loop;
+    fs_batch_op_t *ops;
+    size_t count;
+    uv_work_t req;
+} fs_batch_unit_t;
+
+struct fs_batch_s {
+    uv_coro_types type;
+    int status;
+    bool is_awaiting;
+    bool is_abandoned;
+    /* `open` heading the chain being queued, or -1 */
+    int chain;
+    size_t count;
+    size_t capacity;
+    /* next operation to submit, and those submitted but not completed */
+    size_t next;
+    size_t pending;
+    fs_batch_op_t *ops;
+    wheel_entry_t *expiry;
+    /* coroutine parked in `fs_batch_await()`, see `task_park()` */
+    routine_t *context;
+};
+
+#if defined(UV_CORO_URING)
+/* Submission entries of each loop's ring, and registered file slots, one per chain in flight. */
+#define URING_ENTRIES 256
+#define URING_FILES 64
+
+typedef struct uring_s {
+    int fd;
+    unsigned entries;
+    /* submitted, not completed yet */
+    unsigned inflight;
+    unsigned sq_tail;
+    unsigned *sq_head;
+    unsigned *sq_ktail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void_t sq_ring;
+    void_t cq_ring;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+    int free_slots;
+    int slots[URING_FILES];
+    uv_poll_t poll;
+} uring_t;
+#endif
+
+/* Default amount of corked output that triggers a flush. */
+#define CORK_THRESHOLD Kb(16)
+
+struct stream_cork_s {
+    uv_coro_types type;
+    bool is_active;
+    bool is_auto;
+    bool is_queued;
+    size_t length;
+    size_t capacity;
+    size_t threshold;
+    uv_stream_t *handle;
+    stream_cork_t *next;
+    string data;
+};
+
+/* Stream write waiting on the loop, with its own copy of the data when queued under a deadline. */
+typedef struct write_req_s {
+    bool is_done;
+    bool is_timedout;
+    /* caller gone past its deadline, the write goes on and its callback releases it */
+    bool is_abandoned;
+    int status;
+    routine_t *context;
+    wheel_entry_t *expiry;
+    string copy;
+    uv_write_t req;
+} write_req_t;
+
+/* Function run on the threadpool by `queue_work()`. */
+typedef struct work_req_s {
+    bool is_done;
+    bool is_abandoned;
+    int status;
+    callable_t fn;
+    /* frees a result nobody is left to take, see `work_release()` */
+    func_t release;
+    /* copies of caller data `fn` reads, freed along with the request */
+    string owned;
+    value_t result;
+    wheel_entry_t *expiry;
+    /* coroutine parked on the result, see `task_park()` */
+    routine_t *context;
+    uv_work_t req;
+    /* copied arguments, owned by the request rather than caller scope */
+    value_t argv[1];
+} work_req_t;
+
+/* Per coroutine deadline and threadpool request being awaited, kept as coroutine data,
+previous data restored on return. */
+typedef struct task_state_s {
+    uv_coro_types type;
+    uint64_t expires;
+    routine_t *context;
+    void_t saved;
+    fs_req_t *inflight;
+    work_req_t *working;
+    /* dns lookup awaited through an `uv_init()` helper */
+    uv_args_t *resolving;
+    /* `stream_select()` in progress, and the last result handed out */
+    struct select_s *select;
+    stream_selected_t selected;
+    udp_packet_t packet[1];
+    /* set while this coroutine is suspended in `task_park()` */
+    routine_t *parked;
+    /* client a pooled or reused handler coroutine serves, see `client_scope()` */
+    memory_t *scope;
+} task_state_t;
+
+typedef struct select_s {
+    bool is_done;
+    int count;
+    void_t *handles;
+    task_state_t *state;
+    wheel_entry_t *expiry;
+    select_slot_t *slots;
+} select_t;
+
+/* Position of an armed handle in its `stream_select()` set. */
+struct select_slot_s {
+    select_t *sel;
+    int index;
+    /* set up for a handle that had none, attached only while armed */
+    uv_args_t *owned;
+};
+
+/* One `stream_bind_cluster()` listener, `stop` wakes it from `stream_cluster_stop()`. */
+typedef struct cluster_s {
+    int status;
+    bool is_stopped;
+    string_t address;
+    stream_cb connected;
+    uv_stream_t *server;
+    uv_async_t *stop;
+    uv_thread_t thread;
+} cluster_t;
+
+/* Task handed to `uv_coro_task()`, arguments are rebuilt on the worker that runs it. */
+typedef struct task_job_s {
+    callable_t fn;
+    size_t n_args;
+    value_t argv[1];
+} task_job_t;
+
+/* Shared queue fed from outside the workers, a ring behind a short lock. */
+typedef struct task_queue_s {
+    uv_mutex_t lock;
+    size_t head;
+    size_t tail;
+    size_t capacity;
+    task_job_t **jobs;
+} task_queue_t;
+
+/* Slots of a `task_deque_t`, replaced by one twice the size when full. Replaced rings
+are kept until the deque goes, a thief may still be reading them. */
+typedef struct task_ring_s {
+    int64_t capacity;
+    struct task_ring_s *retired;
+    task_job_t *jobs[1];
+} task_ring_t;
+
+/* Chase-Lev deque, owner pushes and pops the bottom, thieves take from the top. */
+typedef struct task_deque_s {
+    int64_t top;
+    int64_t bottom;
+    task_ring_t *ring;
+} task_deque_t;
+
+typedef struct task_worker_s {
+    int id;
+    bool is_parked;
+    bool is_woken;
+    /* tasks started on this worker and not finished */
+    int running;
+    /* `task_main()` coroutine, while parked behind running tasks */
+    routine_t *context;
+    uv_thread_t thread;
+    uv_async_t *wakeup;
+    task_deque_t deque;
+    struct task_runtime_s *runtime;
+} task_worker_t;
+
+typedef struct task_runtime_s {
+    bool is_stopping;
+    int count;
+    size_t pending;
+    uv_mutex_t lock;
+    task_queue_t injector;
+    task_worker_t *workers;
+} task_runtime_t;
+
 struct spawn_s {
     uv_coro_types type;
     rid_t id;
@@ -20,1431 +474,4890 @@ struct spawn_s {
     uv_process_t process[1];
 };
 
+/* Submit requests from the calling coroutine, instead of from inside a `coro_await()` helper. */
+static bool uv_coro_direct = true;
+/* Let `fs_batch()` use io_uring where the kernel supports it, see `uv_coro_uring_set()`. */
+static bool uv_coro_uring = true;
+/* How `uv_coro_run()` waits on the loop, see `uv_coro_run_set()`. */
+static uv_coro_run_mode uv_coro_mode = UV_CORO_RUN_NOWAIT;
+/* Coroutine stack size set by `main()`, handler stacks are bucketed from 16Kb up to 8Mb. */
+#define STACK_CLASS_MIN Kb(16)
+#define STACK_CLASS_MAX Kb(8192)
+static u32 uv_coro_stack_size = Kb(64);
+/* Worker threads started by `uv_coro_workers()`, each thread finds its own through `task_key`. */
+static task_runtime_t *uv_coro_runtime = nullptr;
+static uv_key_t task_key;
+static uv_once_t task_once = UV_ONCE_INIT;
+/* Running `stream_bind_cluster()` listeners, each thread finds its own through `cluster_key`. */
+static cluster_t *uv_coro_cluster = nullptr;
+static int uv_coro_cluster_count = 0;
+static uv_once_t cluster_once = UV_ONCE_INIT;
+static uv_mutex_t cluster_lock;
+static uv_key_t cluster_key;
+static u32 uv_coro_spins = 0;
+static u32 uv_coro_max_block = 0;
 static char uv_coro_powered_by[SCRAPE_SIZE] = nil;
 static char uv_coro_host[UV_MAXHOSTNAMESIZE] = nil;
 static uv_fs_poll_t *fs_poll_create(void);
 static uv_fs_event_t *fs_event_create(void);
 static uv_tcp_t *tls_tcp_create(void_t extra);
 static void_t fs_init(params_t);
+static int fs_submit(fs_req_t *fs);
+static void fs_cleanup(uv_fs_t *req);
 static void_t uv_init(params_t);
 static value_t uv_start(uv_args_t *uv_args, int type, size_t n_args, bool is_request);
 static void dummy_free(void_t ptr) {}
+static void uv_create_loop(void);
+static void uv_coro_shutdown(void_t);
+static u32 uv_coro_sleep(u32 ms);
+static void _close_cb(uv_handle_t *handle);
 
 static RAII_INLINE uv_args_t *uv_server_data(void) {
     return (uv_args_t *)interrupt_data();
 }
 
-static RAII_INLINE void uv_log_error(int err) {
-    fprintf(stderr, "Error: %s\033[0K\n\r", uv_strerror(err));
+static loop_data_t *uv_loop_data(void) {
+    uv_loop_t *loop = uv_coro_loop();
+    if (is_empty(loop->data))
+        loop->data = try_calloc(1, sizeof(loop_data_t));
+
+    return (loop_data_t *)loop->data;
 }
 
-static void_t uv_coro_abort(void_t handle, int err, routine_t *co) {
-    if (!is_empty(handle))
-        RAII_FREE(handle);
+#if defined(UV_CORO_URING)
+static void uring_free(uring_t *ring) {
+    if (!is_empty(ring->sqes))
+        munmap(ring->sqes, ring->sqes_size);
 
-    uv_log_error(err);
-    return coro_await_erred(co, err);
+    if (!is_empty(ring->cq_ring) && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_size);
+
+    if (!is_empty(ring->sq_ring))
+        munmap(ring->sq_ring, ring->sq_size);
+
+    close(ring->fd);
+    RAII_FREE(ring);
 }
 
-static void_t uv_coro_sockaddr(const char *host, int port, struct sockaddr_in6 *addr6, struct sockaddr_in *addr) {
-    void_t addr_set = nullptr;
-    int r = RAII_ERR;
-    if (is_str_in(host, ":") && !(r = uv_ip6_addr(host, port, (struct sockaddr_in6 *)addr6))) {
-        addr_set = addr6;
-    } else if (is_str_in(host, ".") && !(r = uv_ip4_addr(host, port, (struct sockaddr_in *)addr))) {
-        addr_set = addr;
+static void uring_closed(uv_handle_t *handle) {
+    uring_free((uring_t *)uv_handle_get_data(handle));
+}
+#endif
+
+static int cork_flush(stream_cork_t *cork);
+static void pool_close(worker_pool_t *pool, bool is_draining);
+static void stacks_close(loop_data_t *data);
+static void uv_loop_data_close(uv_loop_t *loop) {
+    loop_data_t *data = (loop_data_t *)loop->data;
+    stream_cork_t *cork;
+    if (is_empty(data))
+        return;
+
+    while (cork = data->corked) {
+        data->corked = cork->next;
+        cork->is_queued = false;
+        cork_flush(cork);
     }
 
-    if (r)
-        return uv_coro_abort(nullptr, r, coro_active());
+    if (!is_empty(data->corker)) {
+        uv_close(handler(data->corker), _close_cb);
+        data->corker = nullptr;
+    }
 
-    return addr_set;
+    if (!is_empty(data->ticker)) {
+        uv_close(handler(data->ticker), _close_cb);
+        data->ticker = nullptr;
+    }
+
+    if (!is_empty(data->waker)) {
+        uv_close(handler(data->waker), _close_cb);
+        data->waker = nullptr;
+    }
+
+    if (!is_empty(data->pool)) {
+        pool_close(data->pool, false);
+        data->pool = nullptr;
+    }
+
+    stacks_close(data);
+
+#if defined(UV_CORO_URING)
+    if (!is_empty(data->uring)) {
+        uv_close(handler(&data->uring->poll), uring_closed);
+        data->uring = nullptr;
+    }
+#endif
 }
 
-static void uv_arguments_free(uv_args_t *uv_args) {
-    if (is_type(uv_args, UV_CORO_ARGS)) {
-        if (!uv_args->is_freeable) {
-            array_delete(uv_args->args);
-            memset(uv_args, RAII_ERR, sizeof(raii_type));
-            RAII_FREE(uv_args);
+static void uv_loop_data_free(uv_loop_t *loop) {
+    loop_data_t *data = (loop_data_t *)loop->data;
+    buffer_t *buffer;
+    fs_req_t *fs;
+    wheel_entry_t *entry;
+    int i;
+    if (is_empty(data))
+        return;
+
+    for (i = 0; i < BUFPOOL_CLASSES; i++) {
+        while (buffer = data->idle[i]) {
+            data->idle[i] = buffer->next;
+            RAII_FREE(buffer);
         }
     }
-}
 
-static uv_args_t *uv_arguments(int count, bool auto_free) {
-    uv_args_t *uv_args = nullptr;
-    arrays_t params = nullptr;
-    if (auto_free) {
-        uv_args = (uv_args_t *)calloc_local(1, sizeof(uv_args_t));
-        params = arrays();
-    } else {
-        uv_args = (uv_args_t *)try_calloc(1, sizeof(uv_args_t));
-        params = array_of(get_scope(), 0);
+    while (fs = data->fs_idle) {
+        data->fs_idle = fs->next;
+        RAII_FREE(fs);
     }
 
-    uv_args->n_args = count;
-    uv_args->args = params;
-    uv_args->is_freeable = auto_free;
-    uv_args->is_server = false;
-    uv_args->bind_type = RAII_SCHEME_TCP;
-    uv_args->type = UV_CORO_ARGS;
-    return uv_args;
-}
+    for (i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        while (entry = data->wheel[i / WHEEL_SLOTS][i % WHEEL_SLOTS]) {
+            data->wheel[i / WHEEL_SLOTS][i % WHEEL_SLOTS] = entry->next;
+            RAII_FREE(entry);
+        }
+    }
 
-static void fs_remove_pipe(uv_args_t *uv) {
-    if (uv->bind_type == RAII_SCHEME_PIPE
-        && !uv_fs_unlink(uv_coro_loop(), &uv->req, (string_t)uv->args[2].object, nullptr)) {
-        uv_fs_req_cleanup(&uv->req);
+    while (entry = data->wheel_idle) {
+        data->wheel_idle = entry->next;
+        RAII_FREE(entry);
     }
+
+    RAII_FREE(data);
+    loop->data = nullptr;
 }
 
-static void uv_close_deferred(void_t handle) {
-    if (is_pipe_stdin(handle)) {
-        uv_close(handler(((pipe_in_t *)handle)->input), nullptr);
-    } else if (is_pipe_stdout(handle)) {
-        uv_close(handler(((pipe_out_t *)handle)->output), nullptr);
-    } else if (is_pipe_file(handle)) {
-        uv_close(handler(((pipe_file_t *)handle)->file), nullptr);
-    } else if (is_tty_in(handle)) {
-        uv_close(handler(((tty_in_t *)handle)->input), nullptr);
-    } else if (is_tty_out(handle)) {
-        uv_close(handler(((tty_out_t *)handle)->output), nullptr);
-    } else if (is_tty_err(handle)) {
-        uv_close(handler(((tty_err_t *)handle)->err), nullptr);
-    } else if (is_pipepair(handle)) {
-        pipepair_t *pair = (pipepair_t *)handle;
-        uv_close(handler(pair->input), nullptr);
-        uv_close(handler(pair->output), nullptr);
-    } else if (is_socketpair(handle)) {
-        socketpair_t *pair = (socketpair_t *)handle;
-        uv_close(handler(pair->reader), nullptr);
-        uv_close(handler(pair->writer), nullptr);
+string bufpool_get(size_t size, size_t *capacity) {
+    loop_data_t *data = uv_loop_data();
+    buffer_t *buffer = nullptr;
+    size_t size_class = 0, class_size = BUFPOOL_SMALLEST;
+
+    while (class_size < size && size_class < BUFPOOL_CLASSES) {
+        class_size <<= 1;
+        size_class++;
+    }
+
+    if (size_class < BUFPOOL_CLASSES && !is_empty(buffer = data->idle[size_class])) {
+        data->idle[size_class] = buffer->next;
+        data->idle_count[size_class]--;
+        data->stats.cached--;
+        data->stats.hits++;
     } else {
-        uv_close(handler(handle), nullptr);
+        if (size_class == BUFPOOL_CLASSES)
+            class_size = size;
+
+        buffer = try_malloc(sizeof(buffer_t) + class_size);
+        buffer->size_class = size_class;
+        buffer->capacity = class_size;
+        data->stats.misses++;
     }
 
-    RAII_FREE(handle);
+    buffer->next = nullptr;
+    if (!is_empty(capacity))
+        *capacity = buffer->capacity;
+
+    return (string)(buffer + 1);
 }
 
-static void _close_cb(uv_handle_t *handle) {
-    if (!handle)
+/* Buffers go back to the pool of the loop running on the calling thread, never to
+another thread's, whichever loop handed them out. */
+void bufpool_put(void_t ptr) {
+    buffer_t *buffer;
+    loop_data_t *data;
+    if (is_empty(ptr))
         return;
 
-    memset(handle, 0, sizeof(uv_handle_t));
-    RAII_FREE(handle);
+    buffer = (buffer_t *)ptr - 1;
+    data = uv_loop_data();
+    if (buffer->size_class == BUFPOOL_CLASSES
+        || data->idle_count[buffer->size_class] >= BUFPOOL_IDLE_MAX) {
+        RAII_FREE(buffer);
+        return;
+    }
+
+    buffer->next = data->idle[buffer->size_class];
+    data->idle[buffer->size_class] = buffer;
+    data->idle_count[buffer->size_class]++;
+    data->stats.cached++;
 }
 
-static void uv_close_free(void_t handle) {
-    uv_handle_t *h = handler(handle);
-    if (!h || UV_UNKNOWN_HANDLE == h->type)
-        return;
+RAII_INLINE bufpool_stats_t bufpool_stats(void) {
+    return uv_loop_data()->stats;
+}
 
-    if (!uv_is_closing(h))
-        uv_close(h, _close_cb);
+static wheel_entry_t **wheel_slot(loop_data_t *data, uint64_t expires) {
+    uint64_t delta;
+    int level = 0;
+    if (expires < data->wheel_now)
+        expires = data->wheel_now;
+
+    delta = expires - data->wheel_now;
+    while (level < WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << (WHEEL_BITS * (level + 1))))
+        level++;
+
+    /* beyond the wheel span, park in the farthest slot and re-cascade from there */
+    if (delta >= ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)))
+        expires = data->wheel_now + ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+    return &data->wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK];
 }
 
-static void tls_close_free(void_t handle) {
-    uv_handle_t *h = handler(handle);
-    if (!h || UV_UNKNOWN_HANDLE == h->type)
-        return;
+static void wheel_link(loop_data_t *data, wheel_entry_t *entry) {
+    wheel_entry_t **slot = wheel_slot(data, entry->expires);
+    entry->next = *slot;
+    if (!is_empty(entry->next))
+        entry->next->pprev = &entry->next;
 
-    uv_tls_close((uv_tls_t *)h, (uv_tls_close_cb)RAII_FREE);
+    entry->pprev = slot;
+    *slot = entry;
 }
 
-static void uv_coro_closer(uv_args_t *uv) {
-    if (uv->req_type == UV_GETNAMEINFO) {
-        RAII_FREE(uv->args[0].object);
-    } else if (uv->req_type == UV_GETADDRINFO) {
-        uv_freeaddrinfo((addrinfo_t *)uv->args[0].object);
-    } else {
-        uv_close_free(uv->args[0].object);
+static void wheel_unlink(wheel_entry_t *entry) {
+    *entry->pprev = entry->next;
+    if (!is_empty(entry->next))
+        entry->next->pprev = entry->pprev;
+
+    entry->next = nullptr;
+    entry->pprev = nullptr;
+}
+
+/* Earliest time something in the wheel needs attention, an expiry or a cascade. */
+static uint64_t wheel_next(loop_data_t *data) {
+    uint64_t next = UINT64_MAX, block, at;
+    int level, i;
+    for (level = 0; level < WHEEL_LEVELS; level++) {
+        block = data->wheel_now >> (WHEEL_BITS * level);
+        for (i = 0; i < WHEEL_SLOTS; i++) {
+            if (is_empty(data->wheel[level][(block + i) & WHEEL_MASK]))
+                continue;
+
+            if (level == 0)
+                at = data->wheel_now + i;
+            else
+                at = (block + (i ? i : WHEEL_SLOTS)) << (WHEEL_BITS * level);
+
+            if (at < next)
+                next = at;
+
+            break;
+        }
     }
 
-    uv_arguments_free(uv);
+    return next;
 }
 
-static void timer_cb(uv_timer_t *handle) {
-    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
-    routine_t *co = uv->context;
-    uv_timer_stop(handle);
-    coro_halt_set(get_coro_context(get_coro_context(co)));
-    coro_await_finish(co, nullptr, 0, false);
+static void wheel_tick_cb(uv_timer_t *handle);
+static void wheel_arm(loop_data_t *data, uint64_t at) {
+    uint64_t now = uv_now(uv_coro_loop());
+    data->wheel_armed = at;
+    uv_timer_start(data->ticker, wheel_tick_cb, (at > now ? at - now : 0), 0);
 }
 
-static void fs_event_cleanup(uv_args_t *uv_args, routine_t *co, int status) {
-    arrays_t arr = interrupt_array();
-    i32 i, inset = interrupt_code();
-    if (arr && inset) {
-        for (i = 0; i < $size(arr); i = i + 3) {
-            if ((uv_fs_type)arr[i].integer == uv_args->fs_type && (uv_args_t *)arr[i + 1].object == uv_args) {
-                arr[i].integer = RAII_ERR;
-                inset--;
+static void wheel_tick_cb(uv_timer_t *handle) {
+    loop_data_t *data = (loop_data_t *)uv_handle_get_data(handler(handle));
+    uint64_t tick, next, target = uv_now(uv_coro_loop());
+    wheel_entry_t *entry, *list;
+    int level;
+
+    while (data->wheel_count && data->wheel_now <= target) {
+        /* skip ahead over ticks with nothing to expire or cascade */
+        if ((next = wheel_next(data)) > data->wheel_now) {
+            data->wheel_now = (next > target) ? target + 1 : next;
+            continue;
+        }
+
+        tick = data->wheel_now++;
+        for (level = 1; level < WHEEL_LEVELS; level++) {
+            if (tick & (((uint64_t)1 << (WHEEL_BITS * level)) - 1))
                 break;
+
+            list = data->wheel[level][(tick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+            data->wheel[level][(tick >> (WHEEL_BITS * level)) & WHEEL_MASK] = nullptr;
+            while (entry = list) {
+                list = entry->next;
+                wheel_link(data, entry);
             }
         }
 
-        if (!inset) {
-            array_delete(arr);
-            interrupt_array_set(nullptr);
-        }
+        while (entry = data->wheel[0][tick & WHEEL_MASK]) {
+            wheel_unlink(entry);
+            if (entry->expires > tick) {
+                wheel_link(data, entry);
+                continue;
+            }
 
-        interrupt_code_set(inset);
+            data->wheel_count--;
+            data->wheel_fired++;
+            entry->fired(entry);
+        }
     }
 
-    uv_coro_abort(nullptr, status, co);
-    uv_coro_closer(uv_args);
-    coro_await_exit(co, nullptr, 0, false);
-}
-
-static void fs_event_cb(uv_fs_event_t *handle, string_t filename, int events, int status) {
-    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
-    routine_t *co = (routine_t *)uv_args->context;
-    event_cb watchfunc = (event_cb)uv_args->args[2].func;
-
-    if (status < 0) {
-        uv_fs_event_stop(handle);
-        fs_event_cleanup(uv_args, co, status);
-    } else if ((events & UV_RENAME) || (events & UV_CHANGE)) {
-        watchfunc(filename, events, status);
+    if (!data->wheel_count) {
+        data->wheel_now = target;
+        data->wheel_armed = UINT64_MAX;
+        uv_timer_stop(handle);
+    } else {
+        wheel_arm(data, wheel_next(data));
     }
 }
 
-static RAII_INLINE void_t coro_fs_event(params_t args) {
-    i32 num_args_set = interrupt_code();
-    coro_name("fs_event #%d", coro_active_id());
-    interrupt_code_set(++num_args_set);
-    if (!interrupt_array()) {
-        interrupt_array_set(array_of(coro_scope(), 3, UV_FS_EVENT, args->object, coro_active()));
-    } else {
-        $append_signed(interrupt_array(), UV_FS_EVENT);
-        $append(interrupt_array(), args->object);
-        $append(interrupt_array(), coro_active());
+/* Calls `fired` once `ms` milliseconds pass, entries are recycled per loop. */
+static wheel_entry_t *wheel_start(uint64_t ms, wheel_cb fired, void_t ptr) {
+    loop_data_t *data = uv_loop_data();
+    uint64_t now = uv_now(uv_coro_loop());
+    wheel_entry_t *entry;
+    if (is_empty(data->ticker)) {
+        data->ticker = try_calloc(1, sizeof(uv_timer_t));
+        uv_timer_init(uv_coro_loop(), data->ticker);
+        uv_handle_set_data(handler(data->ticker), (void_t)data);
+        data->wheel_armed = UINT64_MAX;
     }
 
-    return uv_start((uv_args_t *)args->object, UV_FS_EVENT, 3, false).object;
-}
+    if (!data->wheel_count)
+        data->wheel_now = now;
 
-static void fs_poll_cb(uv_fs_poll_t *handle, int status, const uv_stat_t *prev, const uv_stat_t *curr) {
-    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
-    routine_t *co = (routine_t *)uv_args->context;
-    poll_cb pollerfunc = (poll_cb)uv_args->args[2].func;
+    if (!is_empty(entry = data->wheel_idle))
+        data->wheel_idle = entry->next;
+    else
+        entry = try_calloc(1, sizeof(wheel_entry_t));
 
-    if (status < 0) {
-        uv_fs_poll_stop(handle);
-        fs_event_cleanup(uv_args, co, status);
-    } else {
-        pollerfunc(status, prev, curr);
-    }
+    entry->expires = now + ms;
+    entry->fired = fired;
+    entry->data = ptr;
+    wheel_link(data, entry);
+    data->wheel_count++;
+    if (entry->expires < data->wheel_armed)
+        wheel_arm(data, entry->expires);
+
+    return entry;
 }
 
-static RAII_INLINE void_t coro_fs_poll(params_t args) {
-    i32 num_poll_set = interrupt_code();
-    coro_name("fs_poll #%d", coro_active_id());
-    interrupt_code_set(++num_poll_set);
-    if (!interrupt_array()) {
-        interrupt_array_set(array_of(coro_scope(), 3, UV_FS_POLL, args->object, coro_active()));
-    } else {
-        $append_signed(interrupt_array(), UV_FS_POLL);
-        $append(interrupt_array(), args->object);
-        $append(interrupt_array(), coro_active());
+/* Cancels `entry` if still pending, then recycles it. */
+static void wheel_stop(wheel_entry_t *entry) {
+    loop_data_t *data = uv_loop_data();
+    if (!is_empty(entry->pprev)) {
+        wheel_unlink(entry);
+        data->wheel_count--;
     }
 
-    return uv_start((uv_args_t *)args->object, UV_FS_POLL, 4, false).object;
+    entry->fired = nullptr;
+    entry->data = nullptr;
+    entry->next = data->wheel_idle;
+    data->wheel_idle = entry;
 }
 
-static value_t fs_start(uv_args_t *uv_args, uv_fs_type fs_type, size_t n_args, bool is_path) {
-    uv_args->fs_type = fs_type;
-    uv_args->n_args = n_args;
-    uv_args->is_path = is_path;
+/* Gives up on `fs`, queued work is removed from the threadpool,
+running work completes into `fs_cb`, which then just releases it. */
+static void fs_abandon(fs_req_t *fs) {
+    if (!is_empty(fs->expiry)) {
+        wheel_stop(fs->expiry);
+        fs->expiry = nullptr;
+    }
 
-    return coro_await(fs_init, 1, uv_args);
+    fs->is_abandoned = true;
+    uv_cancel(requester(&fs->req));
 }
 
-static value_t uv_start(uv_args_t *uv_args, int type, size_t n_args, bool is_request) {
-    if (uv_args->is_request = is_request)
-        uv_args->req_type = type;
-    else
-        uv_args->handle_type = type;
+/* Request reading from or filling caller buffers, the kernel holds on to them while it runs. */
+static RAII_INLINE bool fs_buffered(fs_req_t *fs) {
+    return fs->fs_type == UV_FS_WRITE || (fs->fs_type == UV_FS_READ && fs->nbufs);
+}
 
-    uv_args->n_args = n_args;
-    return coro_await(uv_init, 1, uv_args);
+/* Close a file opened for a caller that gave up on it. */
+static void fs_close_now(uv_file fd) {
+    uv_fs_t req;
+    uv_fs_close(uv_coro_loop(), &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
 }
 
-static void uv_catch_error(void_t uv) {
-    routine_t *co = ((uv_args_t *)uv)->context;
-    string_t text = err_message();
-    if (!is_empty((void_t)text) && raii_is_caught(get_coro_scope(co), text)) {
-        coro_halt_set(co);
-        coro_await_erred(co, get_coro_err(co));
-    }
+/* Free `work` along with a result its caller gave up on. */
+static void work_release(work_req_t *work) {
+    if (!is_empty(work->release) && !is_empty(work->result.object))
+        work->release(work->result.object);
 
-    uv_arguments_free(uv_server_data());
-    interrupt_data_set(nullptr);
+    RAII_FREE(work->owned);
+    RAII_FREE(work);
 }
 
-static void connect_cb(uv_connect_t *client, int status) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(client));
-    routine_t *co = uv->context;
-
-    if (status < 0)
-        uv_log_error(status);
-    else
-        uv_handle_set_data(handler(uv->args[0].object), (void_t)uv);
+/* Copy of `path` followed by `length` bytes of `data`, for work that can outlive its caller. */
+static string work_copy(string_t path, string_t data, size_t length) {
+    size_t size = strlen(path) + 1;
+    string copy = try_malloc(size + length);
+    memcpy(copy, path, size);
+    if (length)
+        memcpy(copy + size, data, length);
 
-    coro_await_finish(co, nullptr, status, true);
+    return copy;
 }
 
-static RAII_INLINE void on_connect_handshake(uv_tls_t *tls, int status) {
-    RAII_ASSERT(tls->tcp_hdl->data == tls);
-    connect_cb((uv_connect_t *)tls->data, status);
-}
+static void work_abandon(work_req_t *work) {
+    if (work->is_done) {
+        /* `after_work_cb` already ran, nobody else will release it */
+        work_release(work);
+        return;
+    }
 
-static void on_connect(uv_connect_t *req, int status) {
-    evt_ctx_t *ctx = (evt_ctx_t *)uv_req_get_data(requester(req));
-    uv_args_t *uv = (uv_args_t *)ctx->data;
-    routine_t *co = uv->context;
-    uv_tcp_t *tcp = (uv_tcp_t *)req->handle;
+    if (!is_empty(work->expiry)) {
+        wheel_stop(work->expiry);
+        work->expiry = nullptr;
+    }
 
-    if (!status) {
-        //free on uv_tls_close
-        uv_tls_t *client = try_malloc(sizeof(*client));
-        if (uv_tls_init(ctx, tcp, client) < 0) {
-            RAII_FREE(client);
-            req->data = (void_t)uv;
-            connect_cb(req, status);
-            return;
-        }
+    work->is_abandoned = true;
+    uv_cancel(requester(&work->req));
+}
 
-        RAII_ASSERT(tcp->data == client);
-        client->data = (void_t)req;
-        client->uv_args = (void_t)uv;
-        uv_tls_connect(client, on_connect_handshake);
-    } else {
-        req->data = (void_t)uv;
-        connect_cb(req, status);
+static void select_disarm(select_t *sel, int count);
+static void select_clear(task_state_t *state);
+static void request_abandon(uv_args_t *uv);
+static void task_state_release(task_state_t *state) {
+    if (!is_empty(state->inflight)) {
+        fs_abandon(state->inflight);
+        state->inflight = nullptr;
     }
-}
 
-static void on_listen_handshake(uv_tls_t *ut, int status) {
-    uv_args_t *uv = (uv_args_t *)ut->uv_args;
-    routine_t *co = uv->context;
+    if (!is_empty(state->working)) {
+        work_abandon(state->working);
+        state->working = nullptr;
+    }
 
-    if (status < 0)
-        coro_err_set(co, status);
+    if (!is_empty(state->resolving)) {
+        request_abandon(state->resolving);
+        state->resolving = nullptr;
+    }
 
-    coro_await_finish(co, (!status ? streamer(ut->tcp_hdl) : nullptr), status, (status < 0));
-}
+    if (!is_empty(state->select)) {
+        select_disarm(state->select, state->select->count);
+        RAII_FREE(state->select->slots);
+        state->select = nullptr;
+    }
 
-static void connection_cb(uv_stream_t *server, int status) {
-    uv_args_t *uv = nullptr;
-    void_t check = uv_handle_get_data(handler(server));
-    if (is_type(check, UV_CORO_ARGS))
-        uv = (uv_args_t *)check;
-    else
-        uv = (uv_args_t *)((evt_ctx_t *)check)->data;
+    select_clear(state);
+    state->parked = nullptr;
 
-    routine_t *co = uv->context;
-    uv_loop_t *uvLoop = uv_coro_loop();
-    void_t handle = nullptr;
-    int r = status;
-    bool is_ready = false, halt = true;
+    if (get_coro_data(state->context) == (void_t)state)
+        coro_data_set(state->context, state->saved);
 
-    if (status == 0) {
-        if (uv->bind_type == RAII_SCHEME_TLS) {
-            handle = RAII_CALLOC(1, sizeof(uv_tcp_t));
-            r = uv_tcp_init(uvLoop, (uv_tcp_t *)handle);
-            if (!r && !(r = uv_accept(server, (uv_stream_t *)handle))) {
-                uv_tls_t *client = RAII_MALLOC(sizeof(uv_tls_t)); //freed on uv_close callback
-                if (!(r = uv_tls_init(&uv->ctx, handle, client))) {
-                    halt = false;
-                    r = uv_tls_accept(client, on_listen_handshake);
-                    client->uv_args = (void_t)uv;
-                } else {
-                    RAII_FREE(client);
-                }
-            }
-        } else if (uv->bind_type == RAII_SCHEME_TCP) {
-            handle = RAII_CALLOC(1, sizeof(uv_tcp_t));
-            r = uv_tcp_init(uvLoop, (uv_tcp_t *)handle);
-        } else if (uv->bind_type == RAII_SCHEME_PIPE) {
-            handle = RAII_CALLOC(1, sizeof(uv_pipe_t));
-            r = uv_pipe_init(uvLoop, (uv_pipe_t *)handle, 0);
-        }
+    state->type = RAII_ERR;
+}
 
-        if (!r && (uv->bind_type != RAII_SCHEME_TLS)) {
-            if (!(r = uv_accept(server, streamer(handle)))) {
-                is_ready = true;
-                uv_handle_set_data(handler(handle), (void_t)uv);
-            }
-        }
+static task_state_t *task_state(void) {
+    routine_t *co = coro_active();
+    task_state_t *state = (task_state_t *)get_coro_data(co);
+    if (!is_type(state, UV_CORO_TASK)) {
+        state = (task_state_t *)calloc_local(1, sizeof(task_state_t));
+        state->type = UV_CORO_TASK;
+        state->context = co;
+        state->saved = get_coro_data(co);
+        coro_data_set(co, (void_t)state);
+        defer((func_t)task_state_release, state);
     }
 
-    if (r) {
-        uv_log_error(r);
-        if (!is_empty(handle))
-            RAII_FREE(handle);
+    return state;
+}
 
-        coro_err_set(co, r);
-    }
+/* Scope per call state of the library goes to, the one of the client being served on a
+pooled or reused handler coroutine, so none of it outlives that client, otherwise the
+calling coroutine's own. */
+static memory_t *client_scope_of(routine_t *co) {
+    task_state_t *state = (task_state_t *)get_coro_data(co);
+    if (is_type(state, UV_CORO_TASK) && !is_empty(state->scope))
+        return state->scope;
 
-    coro_await_upgrade(co, (is_ready ? streamer(handle) : nullptr),
-                       r, r, halt, (uv->bind_type != RAII_SCHEME_TLS));
+    return get_coro_scope(co);
 }
 
-static void getnameinfo_cb(uv_getnameinfo_t *req, int status, string_t hostname, string_t service) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = uv->context;
-    nameinfo_t *info = uv->dns->info;
+static RAII_INLINE memory_t *client_scope(void) {
+    return client_scope_of(coro_active());
+}
 
-    uv->args[0].object = req;
-    if (status < 0) {
-        info->type = RAII_ERR;
-        uv_coro_abort(nullptr, status, co);
-        uv_coro_closer(uv);
-    } else {
-        info->service = service;
-        info->host = hostname;
-        info->type = UV_CORO_NAME;
-        raii_deferred(get_coro_scope(get_coro_context(co)), (func_t)uv_coro_closer, uv);
-    }
+static RAII_INLINE void client_defer(func_t fn, void_t data) {
+    raii_deferred(client_scope(), fn, data);
+}
 
-    coro_await_finish(co, (status ? nullptr : info), status, false);
+static RAII_INLINE void_t client_calloc(int count, size_t size) {
+    return calloc_full(client_scope(), count, size, RAII_FREE);
 }
 
-static void getaddrinfo_cb(uv_getaddrinfo_t *req, int status, struct addrinfo *res) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = uv->context;
-    addrinfo_t *next = nullptr;
-    int count = 0;
+memory_t *uv_coro_scope(void) {
+    return client_scope();
+}
 
-    uv->args[0].object = res;
-    RAII_FREE(req);
-    if (status < 0) {
-        uv->dns->addr = nullptr;
-        uv->dns->type = RAII_ERR;
-        uv_coro_abort(nullptr, status, co);
-        uv_coro_closer(uv);
-    } else {
-        for (next = res->ai_next; next != nullptr; next = next->ai_next)
-            count++;
+/* Take calling coroutine off the run queue until `task_unpark()`, it is suspended
+in place, no helper coroutine is created or scheduled for it. Callers recheck what
+they wait for, as a wakeup only means something changed. */
+static void task_park(task_state_t *state) {
+    state->parked = state->context;
+    coro_suspend();
+}
 
-        uv->dns->addr = res;
-        uv->dns->count = count;
-        uv->dns->type = UV_CORO_DNS;
-        addrinfo_next(uv->dns);
-        raii_deferred(get_coro_scope(get_coro_context(co)), (func_t)uv_coro_closer, uv);
+/* Put `co` back on the run queue if parked by `task_park()`, from a loop callback
+or another coroutine. */
+static void task_unpark(routine_t *co) {
+    task_state_t *state;
+    routine_t *parked;
+    if (is_empty(co))
+        return;
+
+    state = (task_state_t *)get_coro_data(co);
+    if (is_type(state, UV_CORO_TASK) && !is_empty(parked = state->parked)) {
+        state->parked = nullptr;
+        coro_enqueue(parked);
     }
+}
 
-    coro_await_finish(co, (status ? nullptr : uv->dns), status, false);
+void uv_coro_deadline(u32 ms) {
+    if (!ms && !is_type(get_coro_data(coro_active()), UV_CORO_TASK))
+        return;
+
+    task_state()->expires = ms ? uv_now(uv_coro_loop()) + ms : 0;
 }
 
-static void shutdown_cb(uv_shutdown_t *req, int status) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = uv->context;
+/* Narrows `timeout` to what is left of the calling coroutine deadline, an already
+passed deadline still gets 1ms, so the operation fails from the loop as usual. */
+static u32 deadline_timeout(u32 timeout) {
+    task_state_t *state = (task_state_t *)get_coro_data(coro_active());
+    uint64_t now, left;
+    if (!is_type(state, UV_CORO_TASK) || !state->expires)
+        return timeout;
 
-    if (status < 0) {
-        uv_log_error(status);
-    }
+    now = uv_now(uv_coro_loop());
+    left = state->expires > now ? state->expires - now : 1;
+    return (!timeout || left < timeout) ? (u32)left : timeout;
+}
 
-    coro_await_finish(co, nullptr, status, true);
-    RAII_FREE(req);
+/* Brings calling coroutine deadline in to `ms` from now, unless an earlier one is set,
+returns the deadline to put back with `deadline_restore()`. */
+static uint64_t deadline_narrow(u32 ms) {
+    task_state_t *state = task_state();
+    uint64_t expires = state->expires, until = uv_now(uv_coro_loop()) + ms;
+    if (!expires || until < expires)
+        state->expires = until;
+
+    return expires;
 }
 
-static void write_cb(uv_write_t *req, int status) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = uv->context;
+static RAII_INLINE void deadline_restore(uint64_t expires) {
+    task_state()->expires = expires;
+}
 
-    if (status < 0) {
-        uv_log_error(status);
-    }
+RAII_INLINE void uv_coro_direct_set(bool enable) {
+    uv_coro_direct = enable;
+}
 
-    coro_await_finish(co, nullptr, status, true);
-    RAII_FREE(req);
+RAII_INLINE void uv_coro_uring_set(bool enable) {
+    uv_coro_uring = enable;
 }
 
-static void tls_write_cb(uv_tls_t *tls, int status) {
-    uv_args_t *uv = (uv_args_t *)tls->uv_args;
-    routine_t *co = uv->context;
-    if (status < 0) {
-        uv_log_error(status);
-    }
+int uv_coro_run_set(uv_coro_run_mode mode, u32 spins, u32 max_block) {
+    /* runnable coroutines are out of sight of the loop, only the bound gets them going again */
+    if (mode != UV_CORO_RUN_NOWAIT && !max_block)
+        return UV_EINVAL;
 
-    coro_await_finish(co, nullptr, status, true);
+    uv_coro_mode = mode;
+    uv_coro_spins = (mode == UV_CORO_RUN_ADAPTIVE) ? spins : 0;
+    uv_coro_max_block = max_block;
+    return 0;
 }
 
-static void alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
-    buf->base = try_calloc(1, suggested_size + 1);
-    buf->len = (unsigned int)suggested_size;
+static void waker_cb(uv_timer_t *handle) {
 }
 
-static void read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
-    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(stream));
-    routine_t *co = uv->context;
+/* Worker thread parked with no task of its own running, only its loop can bring more. */
+static bool task_idle(void) {
+    task_worker_t *worker;
+    if (is_empty(uv_coro_runtime))
+        return false;
 
-    if (nread < 0) {
-        if (nread != UV_EOF)
-            uv_log_error(nread);
+    worker = (task_worker_t *)uv_key_get(&task_key);
+    return !is_empty(worker) && !is_empty(worker->context) && !worker->running;
+}
+
+/* Scheduler interrupter, polls the loop, or once passes stop turning up
+I/O completions or expired timers, blocks in it until something arrives or
+`uv_coro_max_block` passes. Runnable coroutines are not visible from here,
+`uv_coro_run_set()` requires a `max_block` to bound how long they wait.
+An idle worker thread always blocks, its wakeup handle brings the next task. */
+static int uv_coro_run(uv_loop_t *loop, uv_run_mode mode) {
+    bool is_idle = mode == UV_RUN_NOWAIT && task_idle();
+#if UV_VERSION_HEX >= 0x012D00
+    loop_data_t *data;
+    uv_metrics_t metrics;
+    bool is_blocking;
+    int r;
+    if (mode != UV_RUN_NOWAIT || (uv_coro_mode == UV_CORO_RUN_NOWAIT && !is_idle))
+        return uv_run(loop, mode);
+
+    data = uv_loop_data();
+    is_blocking = is_idle || (data->idle_passes >= uv_coro_spins && uv_loop_alive(loop));
+    if (is_blocking && uv_coro_max_block) {
+        if (is_empty(data->waker)) {
+            data->waker = try_calloc(1, sizeof(uv_timer_t));
+            uv_timer_init(loop, data->waker);
+            uv_unref(handler(data->waker));
+        }
 
-        uv_read_stop(stream);
+        uv_timer_start(data->waker, waker_cb, uv_coro_max_block, 0);
     }
 
-    coro_await_finish(co, ((nread > 0) ? buf->base : nullptr), nread, false);
-    RAII_FREE(buf->base);
-}
+    r = uv_run(loop, (is_blocking ? UV_RUN_ONCE : UV_RUN_NOWAIT));
+    if (is_blocking && uv_coro_max_block)
+        uv_timer_stop(data->waker);
+
+    uv_metrics_info(loop, &metrics);
+    if (metrics.events != data->events || data->wheel_fired != data->wakeups) {
+        data->events = metrics.events;
+        data->wakeups = data->wheel_fired;
+        data->idle_passes = 0;
+    } else if (data->idle_passes < UINT32_MAX) {
+        data->idle_passes++;
+    }
 
-static void tls_read_cb(uv_tls_t *strm, ssize_t nread, const uv_buf_t *buf) {
-    uv_args_t *uv = (uv_args_t *)strm->uv_args;
-    routine_t *co = uv->context;
+    return r;
+#else
+    /* no loop metrics to tell idle passes apart, keep polling */
+    return uv_run(loop, (is_idle ? UV_RUN_ONCE : mode));
+#endif
+}
 
-    if (nread < 0 && nread != UV_EOF)
-        uv_log_error(nread);
+static fs_req_t *fs_request(uv_fs_type fs_type) {
+    loop_data_t *data = uv_loop_data();
+    fs_req_t *fs = data->fs_idle;
+    if (!is_empty(fs)) {
+        data->fs_idle = fs->next;
+        data->fs_idle_count--;
+    } else {
+        fs = (fs_req_t *)try_calloc(1, sizeof(fs_req_t));
+    }
 
-    coro_await_finish(co, ((nread > 0) ? buf->base : nullptr), nread, (nread < 0));
+    /* the embedded `uv_fs_t` is initialized by `uv_fs_*` itself */
+    memset(fs, 0, offsetof(fs_req_t, req));
+    fs->type = UV_CORO_FS;
+    fs->fs_type = fs_type;
+    return fs;
 }
 
-static void udp_send_cb(uv_udp_send_t *req, int status) {
-    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = uv->context;
-    uv->args[0].object = req;
-    if (status < 0) {
-        uv_log_error(status);
+static void fs_request_free(fs_req_t *fs) {
+    loop_data_t *data = uv_loop_data();
+    if (data->fs_idle_count >= FSREQ_IDLE_MAX) {
+        RAII_FREE(fs);
+        return;
     }
 
-    coro_await_finish(co, nullptr, status, true);
+    fs->type = RAII_ERR;
+    fs->next = data->fs_idle;
+    data->fs_idle = fs;
+    data->fs_idle_count++;
 }
 
-static void udp_alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
-    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
-    if (uv->is_server)
-        buf->base = try_calloc(1, suggested_size + 1);
-    else
-        buf->base = calloc_full(get_coro_scope(get_coro_context(uv->context)),
-                                1, suggested_size + 1, RAII_FREE);
-    buf->len = (unsigned int)suggested_size;
+static RAII_INLINE void uv_log_error(int err) {
+    fprintf(stderr, "Error: %s\033[0K\n\r", uv_strerror(err));
 }
 
-static void udp_recv_cb(uv_udp_t *req, ssize_t nread, const uv_buf_t *buf,
-                        const struct sockaddr *addr, unsigned int flags) {
-    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(req));
-    routine_t *co = uv->context;
-    udp_packet_t *udp = nullptr;
+static void_t uv_coro_abort(void_t handle, int err, routine_t *co) {
+    if (!is_empty(handle))
+        RAII_FREE(handle);
 
-    if (nread < 0) {
-        if (uv->is_server && buf->base)
-            RAII_FREE(buf->base);
-        uv_coro_abort(nullptr, nread, co);
-    } else if (nread > 0) {
-        if (uv->is_server) {
-            udp = try_calloc(1, sizeof(udp_packet_t));
-        } else if ($size(uv->args) == 1) {
-            udp = calloc_full(get_coro_scope(get_coro_context(co)), 1, sizeof(udp_packet_t), RAII_FREE);
-            $append(uv->args, req);
-            $append(uv->args, addr);
-            $append(uv->args, udp);
-            uv->args[0].object = udp->req;
-        } else {
-            udp = (udp_packet_t *)uv->args[3].object;
-        }
+    uv_log_error(err);
+    return coro_await_erred(co, err);
+}
 
-        memcpy((void_t)udp->addr, addr, sizeof(udp->addr));
-        udp->flags = flags;
-        udp->message = (string_t)buf->base;
-        udp->nread = nread;
-        udp->handle = req;
-        udp->args = (uv->is_server) ? nullptr : uv;
-        udp->type = UV_CORO_UDP;
+static void_t uv_coro_sockaddr(const char *host, int port, struct sockaddr_in6 *addr6, struct sockaddr_in *addr) {
+    void_t addr_set = nullptr;
+    int r = RAII_ERR;
+    if (is_str_in(host, ":") && !(r = uv_ip6_addr(host, port, (struct sockaddr_in6 *)addr6))) {
+        addr_set = addr6;
+    } else if (is_str_in(host, ".") && !(r = uv_ip4_addr(host, port, (struct sockaddr_in *)addr))) {
+        addr_set = addr;
     }
 
-    coro_await_finish(co, udp, nread, (nread < 0));
-    uv_udp_recv_stop(req);
-}
+    if (r)
+        return uv_coro_abort(nullptr, r, coro_active());
 
-static RAII_INLINE void fs_cleanup(uv_fs_t *req) {
-    uv_args_t *args = (uv_args_t *)uv_req_get_data(requester(req));
-    uv_fs_req_cleanup(req);
-    uv_arguments_free(args);
+    return addr_set;
 }
 
-static void fs_cb(uv_fs_t *req) {
-    ssize_t result = uv_fs_get_result(req);
-    uv_args_t *fs = (uv_args_t *)uv_req_get_data(requester(req));
-    routine_t *co = fs->context;
-    void_t fs_ptr, data = nullptr;
-    uv_fs_type fs_type = UV_FS_CUSTOM;
-    bool override = false;
+static void uv_arguments_free(uv_args_t *uv_args) {
+    if (is_type(uv_args, UV_CORO_ARGS)) {
+        if (!uv_args->is_freeable) {
+            array_delete(uv_args->args);
+            memset(uv_args, RAII_ERR, sizeof(raii_type));
+            RAII_FREE(uv_args);
+        }
+    }
+}
 
-    if (result < 0) {
-        uv_coro_abort(nullptr, result, co);
+static uv_args_t *uv_arguments(int count, bool auto_free) {
+    uv_args_t *uv_args = nullptr;
+    arrays_t params = nullptr;
+    if (auto_free) {
+        uv_args = (uv_args_t *)client_calloc(1, sizeof(uv_args_t));
+        params = arrays();
     } else {
-        fs_ptr = uv_fs_get_ptr(req);
-        fs_type = uv_fs_get_type(req);
+        uv_args = (uv_args_t *)try_calloc(1, sizeof(uv_args_t));
+        params = array_of(get_scope(), 0);
+    }
 
-        switch (fs_type) {
-            case UV_FS_CLOSE:
-            case UV_FS_SYMLINK:
-            case UV_FS_LINK:
-            case UV_FS_CHMOD:
-            case UV_FS_RENAME:
-            case UV_FS_UNLINK:
-            case UV_FS_RMDIR:
-            case UV_FS_MKDIR:
-            case UV_FS_CHOWN:
-            case UV_FS_UTIME:
-            case UV_FS_FUTIME:
-            case UV_FS_FCHMOD:
-            case UV_FS_FCHOWN:
-            case UV_FS_FTRUNCATE:
-            case UV_FS_FDATASYNC:
-            case UV_FS_FSYNC:
-            case UV_FS_OPEN:
-            case UV_FS_WRITE:
-            case UV_FS_SENDFILE:
-            case UV_FS_ACCESS:
-            case UV_FS_COPYFILE:
-                break;
-            case UV_FS_SCANDIR:
-                override = true;
-                scandir_t *dirents = fs->dir;
-                dirents->started = false;
-                dirents->count = result;
-                dirents->req = req;
-                data = dirents;
-                break;
-            case UV_FS_STATFS:
-            case UV_FS_LSTAT:
-            case UV_FS_STAT:
-            case UV_FS_FSTAT:
-                override = true;
-                memcpy(fs->stat, uv_fs_get_statbuf(req), sizeof(fs->stat));
-                data = fs->stat;
-                break;
-            case UV_FS_READLINK:
-                override = true;
-                data = fs_ptr;
-                break;
-            case UV_FS_READ:
-                override = true;
-                data = fs->buffer;
-                break;
-            case UV_FS_UNKNOWN:
-            case UV_FS_CUSTOM:
-            default:
-                fprintf(stderr, "type: %d not supported.\033[0K\n", fs_type);
-                break;
-        }
+    uv_args->n_args = count;
+    uv_args->args = params;
+    uv_args->is_freeable = auto_free;
+    uv_args->is_server = false;
+    uv_args->bind_type = RAII_SCHEME_TCP;
+    uv_args->type = UV_CORO_ARGS;
+    return uv_args;
+}
+
+static void fs_remove_pipe(uv_args_t *uv) {
+    if (uv->bind_type == RAII_SCHEME_PIPE
+        && !uv_fs_unlink(uv_coro_loop(), &uv->req, (string_t)uv->args[2].object, nullptr)) {
+        uv_fs_req_cleanup(&uv->req);
     }
+}
 
-    coro_await_finish(co, data, result, !override);
-    if (fs_type != UV_FS_SCANDIR) {
-        if (fs_type == UV_FS_READ)
-            RAII_FREE(fs->bufs.base);
+static void uv_close_deferred(void_t handle) {
+    if (is_pipe_stdin(handle)) {
+        uv_close(handler(((pipe_in_t *)handle)->input), nullptr);
+    } else if (is_pipe_stdout(handle)) {
+        uv_close(handler(((pipe_out_t *)handle)->output), nullptr);
+    } else if (is_pipe_file(handle)) {
+        uv_close(handler(((pipe_file_t *)handle)->file), nullptr);
+    } else if (is_tty_in(handle)) {
+        uv_close(handler(((tty_in_t *)handle)->input), nullptr);
+    } else if (is_tty_out(handle)) {
+        uv_close(handler(((tty_out_t *)handle)->output), nullptr);
+    } else if (is_tty_err(handle)) {
+        uv_close(handler(((tty_err_t *)handle)->err), nullptr);
+    } else if (is_pipepair(handle)) {
+        pipepair_t *pair = (pipepair_t *)handle;
+        uv_close(handler(pair->input), nullptr);
+        uv_close(handler(pair->output), nullptr);
+    } else if (is_socketpair(handle)) {
+        socketpair_t *pair = (socketpair_t *)handle;
+        uv_close(handler(pair->reader), nullptr);
+        uv_close(handler(pair->writer), nullptr);
+    } else if (!uv_is_closing(handler(handle))) {
+        uv_close(handler(handle), nullptr);
+    }
 
-        fs_cleanup(req);
+    RAII_FREE(handle);
+}
+
+static void _close_cb(uv_handle_t *handle) {
+    if (!handle)
+        return;
+
+    memset(handle, 0, sizeof(uv_handle_t));
+    RAII_FREE(handle);
+}
+
+static void uv_close_free(void_t handle) {
+    uv_handle_t *h = handler(handle);
+    if (!h || UV_UNKNOWN_HANDLE == h->type)
+        return;
+
+    if (!uv_is_closing(h))
+        uv_close(h, _close_cb);
+}
+
+static void tls_close_free(void_t handle) {
+    uv_handle_t *h = handler(handle);
+    if (!h || UV_UNKNOWN_HANDLE == h->type)
+        return;
+
+    uv_tls_close((uv_tls_t *)h, (uv_tls_close_cb)RAII_FREE);
+}
+
+static void uv_coro_closer(uv_args_t *uv) {
+    if (uv->req_type == UV_GETNAMEINFO) {
+        RAII_FREE(uv->args[0].object);
+    } else if (uv->req_type == UV_GETADDRINFO) {
+        uv_freeaddrinfo((addrinfo_t *)uv->args[0].object);
+    } else {
+        uv_close_free(uv->args[0].object);
     }
+
+    uv_arguments_free(uv);
 }
 
-static void_t fs_init(params_t uv_args) {
-    uv_loop_t *uvLoop = uv_coro_loop();
-    uv_args_t *fs = uv_args->object;
-    uv_fs_t *req = &fs->req;
-    arrays_t args = fs->args;
-    routine_t *co = coro_active();
-    int result = UV_ENOENT;
+static void timer_cb(uv_timer_t *handle) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
+    routine_t *co = uv->context;
+    uv_timer_stop(handle);
+    coro_halt_set(get_coro_context(get_coro_context(co)));
+    coro_await_finish(co, nullptr, 0, false);
+}
 
-    if (fs->is_path) {
-        string_t path = args[0].char_ptr;
-        switch (fs->fs_type) {
-            case UV_FS_OPEN:
-                result = uv_fs_open(uvLoop, req, path, args[1].integer, args[2].integer, fs_cb);
-                break;
-            case UV_FS_UNLINK:
-                result = uv_fs_unlink(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_MKDIR:
-                result = uv_fs_mkdir(uvLoop, req, path, args[1].integer, fs_cb);
-                break;
-            case UV_FS_RMDIR:
-                result = uv_fs_rmdir(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_RENAME:
-                result = uv_fs_rename(uvLoop, req, path, args[1].char_ptr, fs_cb);
-                break;
-            case UV_FS_ACCESS:
-                result = uv_fs_access(uvLoop, req, path, args[1].integer, fs_cb);
-                break;
-            case UV_FS_COPYFILE:
-                result = uv_fs_copyfile(uvLoop, req, path, args[1].char_ptr, args[2].integer, fs_cb);
-                break;
-            case UV_FS_CHMOD:
-                result = uv_fs_chmod(uvLoop, req, path, args[1].integer, fs_cb);
-                break;
-            case UV_FS_UTIME:
-                result = uv_fs_utime(uvLoop, req, path, args[1].precision, args[2].precision, fs_cb);
-                break;
-            case UV_FS_CHOWN:
-                result = uv_fs_chown(uvLoop, req, path, (uv_uid_t)args[1].uchar, (uv_uid_t)args[2].uchar, fs_cb);
-                break;
-            case UV_FS_LINK:
-                result = uv_fs_link(uvLoop, req, path, (string_t)args[1].char_ptr, fs_cb);
-                break;
-            case UV_FS_SYMLINK:
-                result = uv_fs_symlink(uvLoop, req, path, (string_t)args[1].char_ptr, args[2].integer, fs_cb);
-                break;
-            case UV_FS_LSTAT:
-                result = uv_fs_lstat(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_STAT:
-                result = uv_fs_stat(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_STATFS:
-                result = uv_fs_statfs(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_SCANDIR:
-                result = uv_fs_scandir(uvLoop, req, path, args[1].integer, fs_cb);
-                break;
-            case UV_FS_MKDTEMP:
-                result = uv_fs_mkdtemp(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_MKSTEMP:
-                result = uv_fs_mkstemp(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_READLINK:
-                result = uv_fs_readlink(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_REALPATH:
-                result = uv_fs_realpath(uvLoop, req, path, fs_cb);
-                break;
-            case UV_FS_UNKNOWN:
-            case UV_FS_CUSTOM:
-            default:
-                fprintf(stderr, "type: %d not supported.\033[0K\n", fs->fs_type);
+static void fs_event_cleanup(uv_args_t *uv_args, routine_t *co, int status) {
+    arrays_t arr = interrupt_array();
+    i32 i, inset = interrupt_code();
+    if (arr && inset) {
+        for (i = 0; i < $size(arr); i = i + 3) {
+            if ((uv_fs_type)arr[i].integer == uv_args->fs_type && (uv_args_t *)arr[i + 1].object == uv_args) {
+                arr[i].integer = RAII_ERR;
+                inset--;
                 break;
+            }
+        }
+
+        if (!inset) {
+            array_delete(arr);
+            interrupt_array_set(nullptr);
         }
+
+        interrupt_code_set(inset);
+    }
+
+    uv_coro_abort(nullptr, status, co);
+    uv_coro_closer(uv_args);
+    coro_await_exit(co, nullptr, 0, false);
+}
+
+static void fs_event_cb(uv_fs_event_t *handle, string_t filename, int events, int status) {
+    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
+    routine_t *co = (routine_t *)uv_args->context;
+    event_cb watchfunc = (event_cb)uv_args->args[2].func;
+
+    if (status < 0) {
+        uv_fs_event_stop(handle);
+        fs_event_cleanup(uv_args, co, status);
+    } else if ((events & UV_RENAME) || (events & UV_CHANGE)) {
+        watchfunc(filename, events, status);
+    }
+}
+
+static RAII_INLINE void_t coro_fs_event(params_t args) {
+    i32 num_args_set = interrupt_code();
+    coro_name("fs_event #%d", coro_active_id());
+    interrupt_code_set(++num_args_set);
+    if (!interrupt_array()) {
+        interrupt_array_set(array_of(coro_scope(), 3, UV_FS_EVENT, args->object, coro_active()));
     } else {
-        uv_file fd = args[0].integer;
-        switch (fs->fs_type) {
-            case UV_FS_FSTAT:
-                result = uv_fs_fstat(uvLoop, req, fd, fs_cb);
-                break;
-            case UV_FS_SENDFILE:
-                result = uv_fs_sendfile(uvLoop, req, fd, args[1].integer, args[2].long_long, args[3].max_size, fs_cb);
-                break;
-            case UV_FS_CLOSE:
-                result = uv_fs_close(uvLoop, req, fd, fs_cb);
-                break;
-            case UV_FS_FSYNC:
-                result = uv_fs_fsync(uvLoop, req, fd, fs_cb);
-                break;
+        $append_signed(interrupt_array(), UV_FS_EVENT);
+        $append(interrupt_array(), args->object);
+        $append(interrupt_array(), coro_active());
+    }
+
+    return uv_start((uv_args_t *)args->object, UV_FS_EVENT, 3, false).object;
+}
+
+static void fs_poll_cb(uv_fs_poll_t *handle, int status, const uv_stat_t *prev, const uv_stat_t *curr) {
+    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
+    routine_t *co = (routine_t *)uv_args->context;
+    poll_cb pollerfunc = (poll_cb)uv_args->args[2].func;
+
+    if (status < 0) {
+        uv_fs_poll_stop(handle);
+        fs_event_cleanup(uv_args, co, status);
+    } else {
+        pollerfunc(status, prev, curr);
+    }
+}
+
+static RAII_INLINE void_t coro_fs_poll(params_t args) {
+    i32 num_poll_set = interrupt_code();
+    coro_name("fs_poll #%d", coro_active_id());
+    interrupt_code_set(++num_poll_set);
+    if (!interrupt_array()) {
+        interrupt_array_set(array_of(coro_scope(), 3, UV_FS_POLL, args->object, coro_active()));
+    } else {
+        $append_signed(interrupt_array(), UV_FS_POLL);
+        $append(interrupt_array(), args->object);
+        $append(interrupt_array(), coro_active());
+    }
+
+    return uv_start((uv_args_t *)args->object, UV_FS_POLL, 4, false).object;
+}
+
+static void fs_expired(wheel_entry_t *entry) {
+    fs_req_t *fs = (fs_req_t *)entry->data;
+    task_state_t *state;
+    fs->expiry = nullptr;
+    wheel_stop(entry);
+    /* already running on caller buffers, which must outlive it, wait for it to complete */
+    if (fs_buffered(fs) && uv_cancel(requester(&fs->req)))
+        return;
+
+    fs_abandon(fs);
+    if (!fs->is_direct) {
+        /* helper awaited by caller, whose state tracks the request */
+        state = (task_state_t *)get_coro_data(get_coro_context(fs->context));
+        if (is_type(state, UV_CORO_TASK) && state->inflight == fs)
+            state->inflight = nullptr;
+
+        uv_coro_abort(nullptr, UV_ETIMEDOUT, fs->context);
+        return;
+    }
+
+    uv_log_error(UV_ETIMEDOUT);
+    fs->status = UV_ETIMEDOUT;
+    fs->data = nullptr;
+    fs->is_done = true;
+    task_unpark(fs->context);
+}
+
+static value_t fs_start(fs_req_t *fs) {
+    value_t value = nil;
+    task_state_t *state;
+    u32 timeout;
+    if (!uv_coro_direct) {
+        /* `fs_init()` tracks the request and arms the deadline of this coroutine */
+        task_state();
+        fs->timeout = deadline_timeout(0);
+        return coro_await(fs_init, 1, fs);
+    }
+
+    fs->is_direct = true;
+    fs->context = coro_active();
+    if (fs->status = fs_submit(fs)) {
+        uv_log_error((int)fs->status);
+    } else {
+        /* if this coroutine is halted while parked, its scope abandons the request */
+        state = task_state();
+        state->inflight = fs;
+        if (timeout = deadline_timeout(0))
+            fs->expiry = wheel_start(timeout, fs_expired, fs);
+
+        while (!fs->is_done)
+            task_park(state);
+
+        state->inflight = nullptr;
+        if (!is_empty(fs->expiry)) {
+            wheel_stop(fs->expiry);
+            fs->expiry = nullptr;
+        }
+    }
+
+    if (fs->status < 0)
+        coro_err_set(coro_active(), (int)fs->status);
+
+    switch (fs->fs_type) {
+        case UV_FS_SCANDIR:
+        case UV_FS_STATFS:
+        case UV_FS_LSTAT:
+        case UV_FS_STAT:
+        case UV_FS_FSTAT:
+        case UV_FS_READLINK:
+            value.object = fs->data;
+            break;
+        case UV_FS_READ:
+            if (fs->nbufs)
+                value.long_long = fs->status;
+            else
+                value.object = fs->data;
+            break;
+        case UV_FS_WRITE:
+            /* vectored writes can move more than an `int` holds */
+            if (fs->nbufs)
+                value.long_long = fs->status;
+            else
+                value.integer = (int)fs->status;
+            break;
+        default:
+            value.integer = (int)fs->status;
+            break;
+    }
+
+    if (fs->fs_type == UV_FS_READ && !is_empty(fs->data))
+        client_defer((func_t)RAII_FREE, fs->data);
+
+    /* scandir results stay with the request until iteration finishes,
+    abandoned requests are released by `fs_cb` */
+    if (!fs->is_abandoned && (fs->fs_type != UV_FS_SCANDIR || fs->status < 0))
+        fs_cleanup(&fs->req);
+
+    return value;
+}
+
+static value_t uv_start(uv_args_t *uv_args, int type, size_t n_args, bool is_request) {
+    if (uv_args->is_request = is_request)
+        uv_args->req_type = type;
+    else
+        uv_args->handle_type = type;
+
+    uv_args->n_args = n_args;
+    uv_args->expiry = nullptr;
+    /* dns lookups are tracked by this coroutine, see `resolving_clear()` */
+    if (is_request && (type == UV_GETADDRINFO || type == UV_GETNAMEINFO))
+        task_state();
+
+    return coro_await(uv_init, 2, uv_args, (size_t)deadline_timeout(0));
+}
+
+/* Gives up on a pending dns lookup, queued work is removed from the threadpool,
+running work completes into its callback, which then just releases it. */
+static void request_abandon(uv_args_t *uv) {
+    if (uv->is_abandoned)
+        return;
+
+    /* the lookup request stands in for its consumed input until the callback */
+    uv->is_abandoned = true;
+    uv_cancel((uv_req_t *)uv->args[0].object);
+}
+
+/* Caller of dns lookup `uv` no longer awaits it, whoever finishes it last frees it. */
+static void resolving_clear(uv_args_t *uv) {
+    task_state_t *state = (task_state_t *)get_coro_data(get_coro_context(uv->context));
+    if (is_type(state, UV_CORO_TASK) && state->resolving == uv)
+        state->resolving = nullptr;
+}
+
+/* Deadline of a single `uv_init()` await, owned by its helper, `uv->expiry` marks
+the one armed for the current await of a handle. */
+typedef struct uv_expiry_s {
+    uv_args_t *uv;
+    routine_t *context;
+    wheel_entry_t *entry;
+    /* write or connect left in flight when it fires */
+    uv_req_t *req;
+} uv_expiry_t;
+
+/* Stage `bufs` in a copy owned by `write`, a write queued under a deadline keeps
+going after its caller returned. */
+static uv_buf_t write_stage(write_req_t *write, const uv_buf_t bufs[], unsigned int nbufs) {
+    size_t total = 0, at = 0;
+    unsigned int i;
+    for (i = 0; i < nbufs; i++)
+        total += bufs[i].len;
+
+    write->copy = bufpool_get(total, nullptr);
+    for (i = 0; i < nbufs; i++) {
+        memcpy(write->copy + at, bufs[i].base, bufs[i].len);
+        at += bufs[i].len;
+    }
+
+    return uv_buf_init(write->copy, (unsigned int)total);
+}
+
+static void write_release(write_req_t *write) {
+    bufpool_put(write->copy);
+    RAII_FREE(write);
+}
+
+static void timeout_stop(uv_expiry_t *expiry) {
+    if (!is_empty(expiry->entry)) {
+        wheel_stop(expiry->entry);
+        expiry->entry = nullptr;
+    }
+}
+
+/* Awaited request finished ahead of its deadline, which can no longer fire. */
+static void timeout_clear(uv_args_t *uv) {
+    if (!is_empty(uv->expiry)) {
+        timeout_stop((uv_expiry_t *)uv->expiry);
+        uv->expiry = nullptr;
+    }
+}
+
+/* Abandons whatever `uv` awaits, then resumes caller with `UV_ETIMEDOUT`. */
+static void timeout_fired(wheel_entry_t *entry) {
+    uv_expiry_t *expiry = (uv_expiry_t *)entry->data;
+    uv_args_t *uv = expiry->uv;
+    routine_t *co = uv->context;
+    bool is_plain = true;
+
+    expiry->entry = nullptr;
+    wheel_stop(entry);
+    /* left over from an await this handle already moved past */
+    if (uv->expiry != (void_t)expiry || co != expiry->context)
+        return;
+
+    if (uv->is_request && uv->req_type == UV_WRITE) {
+        /* only this write fails, it goes on from its own copy, `write_cb` releases it */
+        ((write_req_t *)((char *)expiry->req - offsetof(write_req_t, req)))->is_abandoned = true;
+    } else if (uv->is_request && uv->req_type != UV_CONNECT) {
+        is_plain = false;
+        resolving_clear(uv);
+        request_abandon(uv);
+    } else if (uv->is_request) {
+        /* a pending connect can only be aborted by closing its handle,
+        `connect_cb` then just releases the request */
+        uv_req_set_data(expiry->req, nullptr);
+        uv_close(handler(uv->args[0].object), nullptr);
+    } else if (uv->handle_type == UV_CORO_READER) {
+        uv->reader->is_waiting = false;
+    } else if (uv->handle_type == UV_POLL) {
+        uv_poll_stop((uv_poll_t *)uv->args[0].object);
+    } else if (uv->handle_type == UV_UDP) {
+        uv_udp_recv_stop((uv_udp_t *)uv->args[$size(uv->args) == 1 ? 0 : 1].object);
+    } else {
+        is_plain = !is_empty(uv->into) && !is_empty(uv->into->buf.base);
+        uv_read_stop(streamer(uv->args[0].object));
+    }
+
+    uv_log_error(UV_ETIMEDOUT);
+    coro_err_set(co, UV_ETIMEDOUT);
+    coro_await_finish(co, nullptr, UV_ETIMEDOUT, is_plain);
+}
+
+static void timeout_start(uv_args_t *uv, u32 timeout, uv_req_t *req) {
+    uv_expiry_t *expiry;
+    /* TLS reads, writes and handshakes have no cancellation point here */
+    if (uv->bind_type == RAII_SCHEME_TLS)
+        return;
+
+    if (uv->is_request ? (uv->req_type != UV_CONNECT && uv->req_type != UV_WRITE
+                          && uv->req_type != UV_GETADDRINFO && uv->req_type != UV_GETNAMEINFO)
+        : (uv->handle_type != UV_STREAM && uv->handle_type != UV_CORO_READER
+           && uv->handle_type != UV_POLL && uv->handle_type != UV_UDP))
+        return;
+
+    /* stopped with this helper, never by a later await of the same handle */
+    expiry = (uv_expiry_t *)calloc_local(1, sizeof(uv_expiry_t));
+    expiry->uv = uv;
+    expiry->context = uv->context;
+    expiry->req = req;
+    expiry->entry = wheel_start(timeout, timeout_fired, expiry);
+    uv->expiry = (void_t)expiry;
+    defer((func_t)timeout_stop, expiry);
+}
+
+static void uv_catch_error(void_t uv) {
+    routine_t *co = ((uv_args_t *)uv)->context;
+    string_t text = err_message();
+    if (!is_empty((void_t)text) && raii_is_caught(get_coro_scope(co), text)) {
+        coro_halt_set(co);
+        coro_await_erred(co, get_coro_err(co));
+    }
+
+    uv_arguments_free(uv_server_data());
+    interrupt_data_set(nullptr);
+}
+
+static void connect_cb(uv_connect_t *client, int status) {
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(client));
+    routine_t *co;
+
+    RAII_FREE(client);
+    /* timed out, handle already closed by `timeout_fired()` */
+    if (is_empty(uv))
+        return;
+
+    co = uv->context;
+    timeout_clear(uv);
+    if (status < 0)
+        uv_log_error(status);
+    else
+        uv_handle_set_data(handler(uv->args[0].object), (void_t)uv);
+
+    coro_await_finish(co, nullptr, status, true);
+}
+
+static RAII_INLINE void on_connect_handshake(uv_tls_t *tls, int status) {
+    RAII_ASSERT(tls->tcp_hdl->data == tls);
+    connect_cb((uv_connect_t *)tls->data, status);
+}
+
+static void on_connect(uv_connect_t *req, int status) {
+    evt_ctx_t *ctx = (evt_ctx_t *)uv_req_get_data(requester(req));
+    uv_args_t *uv = (uv_args_t *)ctx->data;
+    routine_t *co = uv->context;
+    uv_tcp_t *tcp = (uv_tcp_t *)req->handle;
+
+    if (!status) {
+        //free on uv_tls_close
+        uv_tls_t *client = try_malloc(sizeof(*client));
+        if (uv_tls_init(ctx, tcp, client) < 0) {
+            RAII_FREE(client);
+            req->data = (void_t)uv;
+            connect_cb(req, status);
+            return;
+        }
+
+        RAII_ASSERT(tcp->data == client);
+        client->data = (void_t)req;
+        client->uv_args = (void_t)uv;
+        uv_tls_connect(client, on_connect_handshake);
+    } else {
+        req->data = (void_t)uv;
+        connect_cb(req, status);
+    }
+}
+
+static void on_listen_handshake(uv_tls_t *ut, int status) {
+    uv_args_t *uv = (uv_args_t *)ut->uv_args;
+    routine_t *co = uv->context;
+
+    if (status < 0)
+        coro_err_set(co, status);
+
+    coro_await_finish(co, (!status ? streamer(ut->tcp_hdl) : nullptr), status, (status < 0));
+}
+
+static void accept_push(accept_queue_t *queue, uv_stream_t *client) {
+    uv_handle_set_data(handler(client), nullptr);
+    if (is_empty(queue->tail))
+        queue->head = client;
+    else
+        uv_handle_set_data(handler(queue->tail), (void_t)client);
+
+    queue->tail = client;
+    queue->count++;
+}
+
+static uv_stream_t *accept_shift(uv_args_t *uv) {
+    accept_queue_t *queue = uv->accepts;
+    uv_stream_t *client;
+    if (is_empty(queue) || is_empty(client = queue->head))
+        return nullptr;
+
+    queue->head = (uv_stream_t *)uv_handle_get_data(handler(client));
+    if (is_empty(queue->head))
+        queue->tail = nullptr;
+
+    queue->count--;
+    uv_handle_set_data(handler(client), (void_t)uv);
+    return client;
+}
+
+/* Accepts one pending client, keeping an initialized handle around for the next try. */
+static int accept_next(uv_stream_t *server, uv_args_t *uv, uv_stream_t **client) {
+    void_t handle = uv->accepts->spare;
+    int r = 0;
+    if (is_empty(handle)) {
+        if (uv->bind_type == RAII_SCHEME_PIPE) {
+            handle = RAII_CALLOC(1, sizeof(uv_pipe_t));
+            r = uv_pipe_init(uv_coro_loop(), (uv_pipe_t *)handle, 0);
+        } else {
+            handle = RAII_CALLOC(1, sizeof(uv_tcp_t));
+            r = uv_tcp_init(uv_coro_loop(), (uv_tcp_t *)handle);
+        }
+
+        if (r) {
+            RAII_FREE(handle);
+            return r;
+        }
+
+        uv->accepts->spare = handle;
+    }
+
+    if (!(r = uv_accept(server, streamer(handle)))) {
+        uv->accepts->spare = nullptr;
+        uv_handle_set_data(handler(handle), (void_t)uv);
+        *client = streamer(handle);
+    }
+
+    return r;
+}
+
+/* Closes clients accepted but never taken, and the spare handle, along with their listener. */
+static void accept_release(uv_args_t *uv) {
+    uv_stream_t *client;
+    if (is_empty(uv->accepts))
+        return;
+
+    while (!is_empty(client = accept_shift(uv)))
+        uv_close_free(client);
+
+    if (!is_empty(uv->accepts->spare))
+        uv_close_free(uv->accepts->spare);
+
+    RAII_FREE(uv->accepts);
+    uv->accepts = nullptr;
+}
+
+static void connection_cb(uv_stream_t *server, int status) {
+    uv_args_t *uv = nullptr;
+    void_t check = uv_handle_get_data(handler(server));
+    if (is_type(check, UV_CORO_ARGS))
+        uv = (uv_args_t *)check;
+    else
+        uv = (uv_args_t *)((evt_ctx_t *)check)->data;
+
+    routine_t *co = uv->context;
+    uv_loop_t *uvLoop = uv_coro_loop();
+    uv_stream_t *client = nullptr;
+    void_t handle = nullptr;
+    int r = status;
+    bool is_ready = false, halt = true;
+
+    if (status == 0 && uv->bind_type != RAII_SCHEME_TLS) {
+        /* drain the accept queue, first client resumes `stream_listen()`, the rest wait their turn */
+        while (!(r = accept_next(server, uv, &client))) {
+            if (!is_ready && uv->accepts->is_accepting) {
+                handle = client;
+                is_ready = true;
+            } else {
+                accept_push(uv->accepts, client);
+            }
+        }
+
+        if (r == UV_EAGAIN) {
+            r = 0;
+        } else if (r && is_ready) {
+            uv_log_error(r);
+            r = 0;
+        }
+
+        if (!is_ready && (!r || !uv->accepts->is_accepting)) {
+            if (r)
+                uv_log_error(r);
+
+            return;
+        }
+
+        uv->accepts->is_accepting = false;
+    } else if (status == 0) {
+        handle = RAII_CALLOC(1, sizeof(uv_tcp_t));
+        r = uv_tcp_init(uvLoop, (uv_tcp_t *)handle);
+        if (!r && !(r = uv_accept(server, (uv_stream_t *)handle))) {
+            uv_tls_t *client = RAII_MALLOC(sizeof(uv_tls_t)); //freed on uv_close callback
+            if (!(r = uv_tls_init(&uv->ctx, handle, client))) {
+                halt = false;
+                r = uv_tls_accept(client, on_listen_handshake);
+                client->uv_args = (void_t)uv;
+            } else {
+                RAII_FREE(client);
+            }
+        }
+    }
+
+    if (r) {
+        uv_log_error(r);
+        if (!is_ready && !is_empty(handle))
+            RAII_FREE(handle);
+
+        coro_err_set(co, r);
+    }
+
+    coro_await_upgrade(co, (is_ready ? streamer(handle) : nullptr),
+                       r, r, halt, (uv->bind_type != RAII_SCHEME_TLS));
+}
+
+static void getnameinfo_cb(uv_getnameinfo_t *req, int status, string_t hostname, string_t service) {
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
+    routine_t *co = uv->context;
+    nameinfo_t *info = uv->dns->info;
+
+    uv->args[0].object = req;
+    if (uv->is_abandoned) {
+        uv_coro_closer(uv);
+        return;
+    }
+
+    timeout_clear(uv);
+    resolving_clear(uv);
+
+    if (status < 0) {
+        info->type = RAII_ERR;
+        uv_coro_abort(nullptr, status, co);
+        raii_deferred(client_scope_of(get_coro_context(co)), (func_t)uv_coro_closer, uv);
+    } else {
+        info->service = service;
+        info->host = hostname;
+        info->type = UV_CORO_NAME;
+        raii_deferred(client_scope_of(get_coro_context(co)), (func_t)uv_coro_closer, uv);
+    }
+
+    coro_await_finish(co, (status ? nullptr : info), status, false);
+}
+
+static void getaddrinfo_cb(uv_getaddrinfo_t *req, int status, struct addrinfo *res) {
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
+    routine_t *co = uv->context;
+    addrinfo_t *next = nullptr;
+    int count = 0;
+
+    uv->args[0].object = res;
+    RAII_FREE(req);
+    if (uv->is_abandoned) {
+        uv_coro_closer(uv);
+        return;
+    }
+
+    timeout_clear(uv);
+    resolving_clear(uv);
+
+    if (status < 0) {
+        uv->dns->addr = nullptr;
+        uv->dns->type = RAII_ERR;
+        uv_coro_abort(nullptr, status, co);
+        /* released with the caller, after this coroutine stopped tracking it */
+        raii_deferred(client_scope_of(get_coro_context(co)), (func_t)uv_coro_closer, uv);
+    } else {
+        for (next = res->ai_next; next != nullptr; next = next->ai_next)
+            count++;
+
+        uv->dns->addr = res;
+        uv->dns->count = count;
+        uv->dns->type = UV_CORO_DNS;
+        addrinfo_next(uv->dns);
+        raii_deferred(client_scope_of(get_coro_context(co)), (func_t)uv_coro_closer, uv);
+    }
+
+    coro_await_finish(co, (status ? nullptr : uv->dns), status, false);
+}
+
+static void writable_cb(uv_poll_t *handle, int status, int events) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
+    routine_t *co = uv->context;
+    uv_poll_stop(handle);
+    if (status < 0)
+        uv_log_error(status);
+
+    coro_await_finish(co, nullptr, (status < 0 ? status : events), true);
+}
+
+static void shutdown_cb(uv_shutdown_t *req, int status) {
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
+    routine_t *co = uv->context;
+
+    if (status < 0) {
+        uv_log_error(status);
+    }
+
+    coro_await_finish(co, nullptr, status, true);
+    RAII_FREE(req);
+}
+
+static void write_cb(uv_write_t *req, int status) {
+    write_req_t *write = (write_req_t *)((char *)req - offsetof(write_req_t, req));
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
+
+    if (status < 0) {
+        uv_log_error(status);
+    }
+
+    /* past the deadline the caller, and maybe `uv`, are gone */
+    if (!write->is_abandoned) {
+        timeout_clear(uv);
+        coro_await_finish(uv->context, nullptr, status, true);
+    }
+
+    write_release(write);
+}
+
+static void tls_write_cb(uv_tls_t *tls, int status) {
+    uv_args_t *uv = (uv_args_t *)tls->uv_args;
+    routine_t *co = uv->context;
+    if (status < 0) {
+        uv_log_error(status);
+    }
+
+    coro_await_finish(co, nullptr, status, true);
+}
+
+static void alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handle);
+    if (is_type(uv, UV_CORO_ARGS) && !is_empty(uv->into) && !is_empty(uv->into->buf.base)) {
+        *buf = uv->into->buf;
+        return;
+    }
+
+    size_t capacity;
+    buf->base = bufpool_get(suggested_size, &capacity);
+    buf->len = (unsigned int)capacity - 1;
+}
+
+static void read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(stream));
+    routine_t *co = uv->context;
+
+    if (!is_empty(uv->into) && !is_empty(uv->into->buf.base)) {
+        /* nothing read, caller buffer handed back untouched, keep waiting */
+        if (nread == 0)
+            return;
+
+        if (nread < 0 && nread != UV_EOF)
+            uv_log_error(nread);
+
+        uv->into->buf = uv_buf_init(nullptr, 0);
+        uv_read_stop(stream);
+        coro_await_finish(co, nullptr, nread, true);
+        return;
+    }
+
+    if (nread < 0) {
+        if (nread != UV_EOF)
+            uv_log_error(nread);
+
+        uv_read_stop(stream);
+    } else if (nread > 0) {
+        buf->base[nread] = '\0';
+    }
+
+    coro_await_finish(co, ((nread > 0) ? buf->base : nullptr), nread, false);
+    bufpool_put(buf->base);
+}
+
+/* Appends `length` bytes after those `stream_read_into()` still has to hand out,
+growing the space, a callback can decrypt more than one record at once. */
+static void pending_append(stream_into_t *into, string_t data, size_t length) {
+    size_t capacity = into->pending_cap ? into->pending_cap : Kb(16);
+    string grown;
+    if (into->pending_len + length > into->pending_cap) {
+        while (capacity < into->pending_len + length)
+            capacity <<= 1;
+
+        grown = try_malloc(capacity);
+        if (into->pending_len)
+            memcpy(grown, into->pending, into->pending_len);
+
+        RAII_FREE(into->pending);
+        into->pending = grown;
+        into->pending_cap = capacity;
+    }
+
+    memcpy(into->pending + into->pending_len, data, length);
+    into->pending_len += length;
+}
+
+static void tls_read_cb(uv_tls_t *strm, ssize_t nread, const uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)strm->uv_args;
+    routine_t *co = uv->context;
+    size_t length;
+
+    if (nread < 0 && nread != UV_EOF)
+        uv_log_error(nread);
+
+    if (!is_empty(uv->into) && !is_empty(uv->into->buf.base) && nread > 0) {
+        length = (size_t)nread < uv->into->buf.len ? (size_t)nread : uv->into->buf.len;
+        memcpy(uv->into->buf.base, buf->base, length);
+        /* decrypted data larger than caller buffer, hold remainder for next read */
+        if ((size_t)nread > length)
+            pending_append(uv->into, buf->base + length, (size_t)nread - length);
+
+        uv->into->buf = uv_buf_init(nullptr, 0);
+        coro_await_finish(co, nullptr, length, true);
+        return;
+    }
+
+    coro_await_finish(co, ((nread > 0) ? buf->base : nullptr), nread, (nread < 0));
+}
+
+static void reader_grow(stream_reader_t *reader) {
+    size_t capacity = reader->capacity * 2, tail;
+    string data;
+    if (capacity > reader->max_size)
+        capacity = reader->max_size;
+
+    if (capacity <= reader->capacity)
+        return;
+
+    data = try_malloc(capacity + 1);
+    if (reader->length) {
+        /* linearize any wrapped region while moving into the larger ring */
+        tail = reader->capacity - reader->head;
+        if (tail >= reader->length) {
+            memcpy(data, reader->data + reader->head, reader->length);
+        } else {
+            memcpy(data, reader->data + reader->head, tail);
+            memcpy(data + tail, reader->data, reader->length - tail);
+        }
+    }
+
+    RAII_FREE(reader->data);
+    reader->data = data;
+    reader->head = 0;
+    reader->capacity = capacity;
+}
+
+static RAII_INLINE size_t reader_tail(stream_reader_t *reader) {
+    return (reader->head + reader->length) % reader->capacity;
+}
+
+/* Largest contiguous free region after the buffered data. */
+static size_t reader_space(stream_reader_t *reader) {
+    size_t tail;
+    if (reader->length == reader->capacity)
+        return 0;
+
+    if (reader->length == 0)
+        reader->head = 0;
+
+    tail = reader_tail(reader);
+    return (tail >= reader->head) ? reader->capacity - tail : reader->head - tail;
+}
+
+static void reader_alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    stream_reader_t *reader = ((uv_args_t *)uv_handle_get_data(handle))->reader;
+    size_t space = reader_space(reader);
+    if (space < Kb(4) && reader->capacity < reader->max_size) {
+        reader_grow(reader);
+        space = reader_space(reader);
+    }
+
+    buf->base = reader->data + reader_tail(reader);
+    buf->len = (unsigned int)space;
+}
+
+static void reader_read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(stream));
+    stream_reader_t *reader = uv->reader;
+
+    if (nread == 0)
+        return;
+
+    if (nread == UV_ENOBUFS) {
+        /* ring full at max size, pause until consumer drains it */
+        reader->is_paused = true;
+        uv_read_stop(stream);
+        return;
+    }
+
+    if (nread < 0) {
+        if (nread != UV_EOF)
+            uv_log_error(nread);
+
+        reader->status = (int)nread;
+        uv_read_stop(stream);
+    } else {
+        reader->length += nread;
+        if (reader->length == reader->capacity && reader->capacity == reader->max_size) {
+            reader->is_paused = true;
+            uv_read_stop(stream);
+        }
+    }
+
+    if (reader->is_waiting) {
+        reader->is_waiting = false;
+        coro_await_finish(uv->context, nullptr, nread, true);
+    }
+}
+
+/* Copy out up to `cap` buffered bytes, rearming a paused reader once drained. */
+static size_t reader_consume(stream_reader_t *reader, string out, size_t cap) {
+    size_t length = reader->length < cap ? reader->length : cap, tail;
+    tail = reader->capacity - reader->head;
+    if (tail >= length) {
+        memcpy(out, reader->data + reader->head, length);
+    } else {
+        memcpy(out, reader->data + reader->head, tail);
+        memcpy(out + tail, reader->data, length - tail);
+    }
+
+    reader->head = (reader->head + length) % reader->capacity;
+    reader->length -= length;
+    if (reader->is_paused && reader->length < reader->capacity / 2 && !reader->status) {
+        reader->is_paused = false;
+        uv_read_start(reader->handle, reader_alloc_cb, reader_read_cb);
+    }
+
+    return length;
+}
+
+/* Park calling coroutine until buffered data or end of stream arrives. */
+static int reader_wait(uv_args_t *uv_args) {
+    stream_reader_t *reader = uv_args->reader;
+    int r;
+    if (!reader->length && !reader->status) {
+        reader->is_waiting = true;
+        r = uv_start(uv_args, UV_CORO_READER, 1, false).integer;
+        reader->is_waiting = false;
+        if (r == UV_ETIMEDOUT)
+            return r;
+    }
+
+    return reader->length ? 0 : reader->status;
+}
+
+static void reader_free(stream_reader_t *reader) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(reader->handle));
+    if (!uv_is_closing(handler(reader->handle)))
+        uv_read_stop(reader->handle);
+
+    if (is_type(uv, UV_CORO_ARGS) && uv->reader == reader)
+        uv->reader = nullptr;
+
+    RAII_FREE(reader->data);
+    memset(reader, RAII_ERR, sizeof(uv_coro_types));
+    RAII_FREE(reader);
+}
+
+/* Releases `stream_read_into()` state, along with decrypted bytes still held back. */
+static void into_free(stream_into_t *into) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(into->handle));
+    if (is_type(uv, UV_CORO_ARGS) && uv->into == into)
+        uv->into = nullptr;
+
+    RAII_FREE(into->pending);
+    RAII_FREE(into);
+}
+
+static void udp_send_cb(uv_udp_send_t *req, int status) {
+    uv_args_t *uv = (uv_args_t *)uv_req_get_data(requester(req));
+    routine_t *co = uv->context;
+    uv->args[0].object = req;
+    if (status < 0) {
+        uv_log_error(status);
+    }
+
+    coro_await_finish(co, nullptr, status, true);
+}
+
+static void udp_alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
+    size_t capacity;
+    buf->base = bufpool_get(suggested_size, &capacity);
+    if (!uv->is_server)
+        raii_deferred(client_scope_of(get_coro_context(uv->context)), (func_t)bufpool_put, buf->base);
+
+    buf->len = (unsigned int)capacity - 1;
+}
+
+static void udp_recv_cb(uv_udp_t *req, ssize_t nread, const uv_buf_t *buf,
+                        const struct sockaddr *addr, unsigned int flags) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(req));
+    routine_t *co = uv->context;
+    udp_packet_t *udp = nullptr;
+
+    if (nread <= 0) {
+        if (uv->is_server)
+            bufpool_put(buf->base);
+
+        /* nothing to read, libuv just hands back the buffer */
+        if (nread == 0 && is_empty(addr))
+            return;
+
+        if (nread < 0)
+            uv_coro_abort(nullptr, nread, co);
+    } else {
+        buf->base[nread] = '\0';
+        if (uv->is_server) {
+            udp = try_calloc(1, sizeof(udp_packet_t));
+        } else if ($size(uv->args) == 1) {
+            udp = calloc_full(client_scope_of(get_coro_context(co)), 1, sizeof(udp_packet_t), RAII_FREE);
+            $append(uv->args, req);
+            $append(uv->args, addr);
+            $append(uv->args, udp);
+            uv->args[0].object = udp->req;
+        } else {
+            udp = (udp_packet_t *)uv->args[3].object;
+        }
+
+        memcpy((void_t)udp->addr, addr, sizeof(udp->addr));
+        udp->flags = flags;
+        udp->message = (string_t)buf->base;
+        udp->nread = nread;
+        udp->handle = req;
+        udp->args = (uv->is_server) ? nullptr : uv;
+        udp->type = UV_CORO_UDP;
+    }
+
+    coro_await_finish(co, udp, nread, (nread < 0));
+    uv_udp_recv_stop(req);
+}
+
+static void fs_cleanup(uv_fs_t *req) {
+    fs_req_t *fs = (fs_req_t *)uv_req_get_data(requester(req));
+    uv_fs_req_cleanup(req);
+    fs_request_free(fs);
+}
+
+static void fs_cb(uv_fs_t *req) {
+    ssize_t result = uv_fs_get_result(req);
+    fs_req_t *fs = (fs_req_t *)uv_req_get_data(requester(req));
+    routine_t *co = fs->context;
+    void_t fs_ptr, data = nullptr;
+    uv_fs_type fs_type = UV_FS_CUSTOM;
+    bool override = false;
+    task_state_t *state;
+
+    if (fs->is_abandoned) {
+        /* late or canceled completion, caller storage may already be gone */
+        if (fs->fs_type == UV_FS_READ)
+            RAII_FREE(fs->bufs.base);
+        else if (fs->fs_type == UV_FS_OPEN && result >= 0)
+            fs_close_now((uv_file)result);
+
+        fs_cleanup(req);
+        return;
+    }
+
+    if (!fs->is_direct) {
+        if (!is_empty(fs->expiry)) {
+            wheel_stop(fs->expiry);
+            fs->expiry = nullptr;
+        }
+
+        state = (task_state_t *)get_coro_data(get_coro_context(co));
+        if (is_type(state, UV_CORO_TASK) && state->inflight == fs)
+            state->inflight = nullptr;
+    }
+
+    if (result < 0) {
+        if (fs->is_direct)
+            uv_log_error((int)result);
+        else
+            uv_coro_abort(nullptr, result, co);
+    } else {
+        fs_ptr = uv_fs_get_ptr(req);
+        fs_type = uv_fs_get_type(req);
+
+        switch (fs_type) {
+            case UV_FS_CLOSE:
+            case UV_FS_SYMLINK:
+            case UV_FS_LINK:
+            case UV_FS_CHMOD:
+            case UV_FS_RENAME:
+            case UV_FS_UNLINK:
+            case UV_FS_RMDIR:
+            case UV_FS_MKDIR:
+            case UV_FS_CHOWN:
+            case UV_FS_UTIME:
+            case UV_FS_FUTIME:
+            case UV_FS_FCHMOD:
+            case UV_FS_FCHOWN:
+            case UV_FS_FTRUNCATE:
             case UV_FS_FDATASYNC:
-                result = uv_fs_fdatasync(uvLoop, req, fd, fs_cb);
+            case UV_FS_FSYNC:
+            case UV_FS_LUTIME:
+            case UV_FS_LCHOWN:
+            case UV_FS_MKSTEMP:
+            case UV_FS_MKDTEMP:
+            case UV_FS_REALPATH:
+            case UV_FS_OPEN:
+            case UV_FS_WRITE:
+            case UV_FS_SENDFILE:
+            case UV_FS_ACCESS:
+            case UV_FS_COPYFILE:
+                break;
+            case UV_FS_SCANDIR:
+                override = true;
+                scandir_t *dirents = fs->dir;
+                dirents->started = false;
+                dirents->count = result;
+                dirents->req = req;
+                data = dirents;
+                break;
+            case UV_FS_STATFS:
+                override = true;
+                memcpy(fs->result, fs_ptr, sizeof(uv_statfs_t));
+                data = fs->result;
+                break;
+            case UV_FS_LSTAT:
+            case UV_FS_STAT:
+            case UV_FS_FSTAT:
+                override = true;
+                memcpy(fs->result, uv_fs_get_statbuf(req), sizeof(uv_stat_t));
+                data = fs->result;
+                break;
+            case UV_FS_READLINK:
+                override = true;
+                data = fs_ptr;
+                break;
+            case UV_FS_READ:
+                if (override = !fs->nbufs)
+                    data = fs->bufs.base;
+                break;
+            case UV_FS_UNKNOWN:
+            case UV_FS_CUSTOM:
+            default:
+                fprintf(stderr, "type: %d not supported.\033[0K\n", fs_type);
+                break;
+        }
+    }
+
+    if (fs->is_direct) {
+        /* the waiting coroutine picks up results and releases `fs` */
+        fs->status = result;
+        fs->data = data;
+        fs->is_done = true;
+        task_unpark(co);
+        return;
+    }
+
+    coro_await_finish(co, data, result, !override);
+    if (fs_type != UV_FS_SCANDIR) {
+        if (fs_type == UV_FS_READ)
+            RAII_FREE(fs->bufs.base);
+
+        fs_cleanup(req);
+    }
+}
+
+static int fs_submit(fs_req_t *fs) {
+    uv_loop_t *uvLoop = uv_coro_loop();
+    uv_fs_t *req = &fs->req;
+    const uv_buf_t *bufs = (fs->nbufs ? fs->vbufs : &fs->bufs);
+    unsigned int nbufs = (fs->nbufs ? fs->nbufs : 1);
+    int result = UV_ENOENT;
+
+    switch (fs->fs_type) {
+        case UV_FS_OPEN:
+            result = uv_fs_open(uvLoop, req, fs->path, fs->flags, fs->mode, fs_cb);
+            break;
+        case UV_FS_UNLINK:
+            result = uv_fs_unlink(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_MKDIR:
+            result = uv_fs_mkdir(uvLoop, req, fs->path, fs->mode, fs_cb);
+            break;
+        case UV_FS_RMDIR:
+            result = uv_fs_rmdir(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_RENAME:
+            result = uv_fs_rename(uvLoop, req, fs->path, fs->new_path, fs_cb);
+            break;
+        case UV_FS_ACCESS:
+            result = uv_fs_access(uvLoop, req, fs->path, fs->mode, fs_cb);
+            break;
+        case UV_FS_COPYFILE:
+            result = uv_fs_copyfile(uvLoop, req, fs->path, fs->new_path, fs->flags, fs_cb);
+            break;
+        case UV_FS_CHMOD:
+            result = uv_fs_chmod(uvLoop, req, fs->path, fs->mode, fs_cb);
+            break;
+        case UV_FS_UTIME:
+            result = uv_fs_utime(uvLoop, req, fs->path, fs->atime, fs->mtime, fs_cb);
+            break;
+        case UV_FS_LUTIME:
+            result = uv_fs_lutime(uvLoop, req, fs->path, fs->atime, fs->mtime, fs_cb);
+            break;
+        case UV_FS_CHOWN:
+            result = uv_fs_chown(uvLoop, req, fs->path, fs->uid, fs->gid, fs_cb);
+            break;
+        case UV_FS_LCHOWN:
+            result = uv_fs_lchown(uvLoop, req, fs->path, fs->uid, fs->gid, fs_cb);
+            break;
+        case UV_FS_LINK:
+            result = uv_fs_link(uvLoop, req, fs->path, fs->new_path, fs_cb);
+            break;
+        case UV_FS_SYMLINK:
+            result = uv_fs_symlink(uvLoop, req, fs->path, fs->new_path, fs->flags, fs_cb);
+            break;
+        case UV_FS_LSTAT:
+            result = uv_fs_lstat(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_STAT:
+            result = uv_fs_stat(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_STATFS:
+            result = uv_fs_statfs(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_SCANDIR:
+            result = uv_fs_scandir(uvLoop, req, fs->path, fs->flags, fs_cb);
+            break;
+        case UV_FS_MKDTEMP:
+            result = uv_fs_mkdtemp(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_MKSTEMP:
+            result = uv_fs_mkstemp(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_READLINK:
+            result = uv_fs_readlink(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_REALPATH:
+            result = uv_fs_realpath(uvLoop, req, fs->path, fs_cb);
+            break;
+        case UV_FS_FSTAT:
+            result = uv_fs_fstat(uvLoop, req, fs->fd, fs_cb);
+            break;
+        case UV_FS_SENDFILE:
+            result = uv_fs_sendfile(uvLoop, req, fs->fd, fs->in_fd, fs->offset, fs->length, fs_cb);
+            break;
+        case UV_FS_CLOSE:
+            result = uv_fs_close(uvLoop, req, fs->fd, fs_cb);
+            break;
+        case UV_FS_FSYNC:
+            result = uv_fs_fsync(uvLoop, req, fs->fd, fs_cb);
+            break;
+        case UV_FS_FDATASYNC:
+            result = uv_fs_fdatasync(uvLoop, req, fs->fd, fs_cb);
+            break;
+        case UV_FS_FTRUNCATE:
+            result = uv_fs_ftruncate(uvLoop, req, fs->fd, fs->offset, fs_cb);
+            break;
+        case UV_FS_FCHMOD:
+            result = uv_fs_fchmod(uvLoop, req, fs->fd, fs->mode, fs_cb);
+            break;
+        case UV_FS_FUTIME:
+            result = uv_fs_futime(uvLoop, req, fs->fd, fs->atime, fs->mtime, fs_cb);
+            break;
+        case UV_FS_FCHOWN:
+            result = uv_fs_fchown(uvLoop, req, fs->fd, fs->uid, fs->gid, fs_cb);
+            break;
+        case UV_FS_READ:
+            result = uv_fs_read(uvLoop, req, fs->fd, bufs, nbufs, fs->offset, fs_cb);
+            break;
+        case UV_FS_WRITE:
+            result = uv_fs_write(uvLoop, req, fs->fd, bufs, nbufs, fs->offset, fs_cb);
+            break;
+        case UV_FS_UNKNOWN:
+        case UV_FS_CUSTOM:
+        default:
+            fprintf(stderr, "type: %d not supported.\033[0K\n", fs->fs_type);
+            break;
+    }
+
+    if (!result)
+        uv_req_set_data(requester(req), (void_t)fs);
+
+    return result;
+}
+
+static void_t fs_init(params_t args) {
+    fs_req_t *fs = args->object;
+    routine_t *co = coro_active();
+    task_state_t *state;
+    int result;
+
+    fs->context = co;
+    if (result = fs_submit(fs)) {
+        if (fs->fs_type == UV_FS_READ)
+            RAII_FREE(fs->bufs.base);
+
+        uv_fs_req_cleanup(&fs->req);
+        fs_request_free(fs);
+        return uv_coro_abort(nullptr, result, co);
+    }
+
+    /* kept by the awaiting caller, halting it abandons the request */
+    state = (task_state_t *)get_coro_data(get_coro_context(co));
+    state->inflight = fs;
+    if (fs->timeout)
+        fs->expiry = wheel_start(fs->timeout, fs_expired, fs);
+
+    return 0;
+}
+
+static void_t uv_init(params_t uv_args) {
+    uv_args_t *uv = uv_args->object;
+    arrays_t args = uv->args;
+    int length, r, result = UV_EBADF;
+    uv_handle_t *stream = handler(args[0].object);
+    char name[SCRAPE_SIZE * 2] = nil;
+    u32 timeout = (u32)uv_args[1].max_size;
+    uv_req_t *req = nullptr;
+    uv->context = coro_active();
+    if (uv->is_request) {
+        const uv_buf_t *bufs;
+        unsigned int nbufs;
+        write_req_t *write;
+        uv_buf_t staged;
+        switch (uv->req_type) {
+            case UV_WRITE:
+                if (uv->bind_type == RAII_SCHEME_TLS) {
+                    ((uv_tls_t *)stream)->uv_args = uv;
+                    if (uv->nbufs)
+                        result = uv_tls_writev((uv_tls_t *)stream, uv->vbufs, uv->nbufs, tls_write_cb);
+                    else
+                        result = uv_tls_write((uv_tls_t *)stream, &uv->bufs, tls_write_cb);
+                } else {
+                    write = try_calloc(1, sizeof(write_req_t));
+                    req = requester(&write->req);
+                    bufs = (uv->nbufs ? uv->vbufs : &uv->bufs);
+                    nbufs = (uv->nbufs ? uv->nbufs : 1);
+                    if (timeout) {
+                        staged = write_stage(write, bufs, nbufs);
+                        bufs = &staged;
+                        nbufs = 1;
+                    }
+
+                    if (result = uv_write(&write->req, streamer(stream), bufs, nbufs, write_cb))
+                        write_release(write);
+                }
                 break;
-            case UV_FS_FTRUNCATE:
-                result = uv_fs_ftruncate(uvLoop, req, fd, args[1].long_long, fs_cb);
+            case UV_CONNECT:
+                /* freed by `connect_cb`, which can outlive this coroutine on timeout */
+                req = try_calloc(1, sizeof(uv_connect_t));
+                switch (uv->bind_type) {
+                    case RAII_SCHEME_PIPE:
+                        uv->handle_type = UV_NAMED_PIPE;
+                        uv_pipe_connect((uv_connect_t *)req, (uv_pipe_t *)stream, (string_t)args[1].char_ptr, connect_cb);
+                        result = 0;
+                        break;
+                    case RAII_SCHEME_TLS:
+                        req->data = &uv->ctx;
+                        result = uv_tcp_connect((uv_connect_t *)req, (uv_tcp_t *)stream, (sockaddr_t *)args[1].object, on_connect);
+                        break;
+                    default:
+                        uv->handle_type = UV_TCP;
+                        result = uv_tcp_connect((uv_connect_t *)req, (uv_tcp_t *)stream, (sockaddr_t *)args[1].object, connect_cb);
+                        break;
+                }
+
+                if (result)
+                    RAII_FREE(req);
                 break;
-            case UV_FS_FCHMOD:
-                result = uv_fs_fchmod(uvLoop, req, fd, args[1].integer, fs_cb);
+            case UV_UDP_SEND:
+                req = args[0].object;
+                result = uv_udp_send((uv_udp_send_t *)req, (uv_udp_t *)args[1].object,
+                                     &uv->bufs, 1, (sockaddr_t *)args[2].object, udp_send_cb);
                 break;
-            case UV_FS_FUTIME:
-                result = uv_fs_futime(uvLoop, req, fd, args[1].precision, args[2].precision, fs_cb);
+            case UV_SHUTDOWN:
+                req = try_calloc(1, sizeof(uv_shutdown_t));
+                if (result = uv_shutdown((uv_shutdown_t *)req, streamer(stream), shutdown_cb))
+                    RAII_FREE(req);
+                break;
+            case UV_GETADDRINFO:
+                req = try_calloc(1, sizeof(uv_getaddrinfo_t));
+                result = uv_getaddrinfo(uv_coro_loop(), (uv_getaddrinfo_t *)req,
+                                        getaddrinfo_cb, args[0].char_ptr, args[1].char_ptr,
+                                        (uv->n_args > 2 ? (const addrinfo_t *)args[2].object : nullptr));
+                if (result) {
+                    uv->args[0].object = req;
+                    uv_coro_closer(uv);
+                } else {
+                    /* caller abandons it if halted, the callback frees it either way */
+                    uv->args[0].object = req;
+                    ((task_state_t *)get_coro_data(get_coro_context(uv->context)))->resolving = uv;
+                }
+                break;
+            case UV_GETNAMEINFO:
+                req = try_calloc(1, sizeof(uv_getnameinfo_t));
+                result = uv_getnameinfo(uv_coro_loop(), (uv_getnameinfo_t *)req,
+                                        getnameinfo_cb, (sockaddr_t *)args[0].object,
+                                        args[1].integer);
+                if (result) {
+                    uv->args[0].object = req;
+                    uv_coro_closer(uv);
+                } else {
+                    /* caller abandons it if halted, the callback frees it either way */
+                    uv->args[0].object = req;
+                    ((task_state_t *)get_coro_data(get_coro_context(uv->context)))->resolving = uv;
+                }
+                break;
+            case UV_WORK:
+                /* submitted straight from the caller by `queue_work()` */
+            case UV_RANDOM:
+                break;
+            case UV_UNKNOWN_REQ:
+            default:
+                fprintf(stderr, "type; %d not supported.\033[0K\n", uv->req_type);
+                break;
+        }
+
+        if (uv->bind_type == RAII_SCHEME_TLS)
+            uv->ctx.uv_args = (void_t)uv;
+        else if (!result)
+            uv_req_set_data(req, (void_t)uv);
+
+    } else {
+        if (uv->bind_type != RAII_SCHEME_TLS)
+            uv_handle_set_data(stream, (void_t)uv);
+
+        switch (uv->handle_type) {
+            case UV_FS_EVENT:
+                result = uv_fs_event_start((uv_fs_event_t *)stream, fs_event_cb, args[1].char_ptr, UV_FS_EVENT_RECURSIVE);
+                break;
+            case UV_FS_POLL:
+                result = uv_fs_poll_start((uv_fs_poll_t *)stream, fs_poll_cb, args[1].char_ptr, args[3].integer);
+                break;
+            case UV_POLL:
+                result = uv_poll_start((uv_poll_t *)stream, args[1].integer, writable_cb);
+                break;
+            case UV_CHECK:
+            case UV_IDLE:
+            case UV_NAMED_PIPE:
+            case UV_PREPARE:
+                break;
+            case UV_CORO_LISTEN:
+                if (uv->bind_type == RAII_SCHEME_UDP)
+                    result = uv_udp_recv_start((uv_udp_t *)args[0].object, udp_alloc_cb, udp_recv_cb);
+                else
+                    result = uv_listen((uv_stream_t *)stream, args[1].integer, connection_cb);
+
+                if (!result) {
+                    length = (int)sizeof(uv->dns->name);
+                    switch (uv->bind_type) {
+                        case RAII_SCHEME_PIPE:
+                            length = (int)sizeof(name);
+                            r = uv_pipe_getsockname((const uv_pipe_t *)args[0].object, name, (size_t *)&length);
+                            if (!is_equal(name, args[2].object)
+                                && (r = snprintf(name, sizeof(name), "%s", args[2].object)))
+                                r = 0;
+                            break;
+                        case RAII_SCHEME_UDP:
+                            r = uv_udp_getsockname((const uv_udp_t *)args[0].object, uv->dns->name, &length);
+                            break;
+                        default:
+                            r = uv_tcp_getsockname((const uv_tcp_t *)stream, uv->dns->name, &length);
+                            break;
+                    }
+
+                    if (!r && uv->bind_type != RAII_SCHEME_PIPE) {
+                        if (is_str_in(args[3].char_ptr, ":")) {
+                            uv_ip6_name((const struct sockaddr_in6 *)uv->dns->name, uv->dns->ip, sizeof uv->dns->ip);
+                        } else if (is_str_in(args[3].char_ptr, ".")) {
+                            uv_ip4_name((const struct sockaddr_in *)uv->dns->name, uv->dns->ip, sizeof uv->dns->ip);
+                        }
+                    }
+
+                    fprintf(stdout, "Listening to %s:%d for%s connections, %s.\033[0K\n",
+                            (uv->bind_type == RAII_SCHEME_PIPE ? name : uv->dns->ip),
+                            args[4].integer,
+                            (uv->bind_type == RAII_SCHEME_TLS ? " secure" : ""),
+                            http_std_date(0)
+                    );
+
+                    if (is_empty(uv_server_data()))
+                        interrupt_data_set(uv);
+                }
+                break;
+            case UV_CORO_READER:
+                /* reading already armed, just park until `reader_read_cb` */
+                result = 0;
+                break;
+            case UV_STREAM:
+                if (uv->bind_type == RAII_SCHEME_TLS) {
+                    ((uv_tls_t *)stream)->uv_args = (void_t)uv;
+                    result = uv_tls_read(((uv_tls_t *)stream), tls_read_cb);
+                } else {
+                    result = uv_read_start((uv_stream_t *)stream, alloc_cb, read_cb);
+                }
+                break;
+            case UV_TIMER:
+                defer((func_t)uv_coro_closer, uv);
+                result = uv_timer_start((uv_timer_t *)args[0].object, timer_cb, args[1].ulong_long, 0);
+                break;
+            case UV_HANDLE:
+            case UV_PROCESS:
+            case UV_TCP:
+            case UV_TTY:
+            case UV_UDP:
+                length = $size(args) == 1 ? 0 : 1;
+                result = uv_udp_recv_start((uv_udp_t *)args[length].object, udp_alloc_cb, udp_recv_cb);
+                break;
+            case UV_SIGNAL:
+            case UV_FILE:
+                break;
+            case UV_UNKNOWN_HANDLE:
+            default:
+                fprintf(stderr, "type; %d not supported.\033[0K\n", uv->handle_type);
+                break;
+        }
+    }
+
+    if (result) {
+        uv_log_error(result);
+        coro_await_canceled(uv->context, result);
+    } else if (timeout) {
+        timeout_start(uv, timeout, req);
+    }
+
+    return 0;
+}
+
+static void work_cb(uv_work_t *req) {
+    work_req_t *work = (work_req_t *)uv_req_get_data(requester(req));
+    work->result.object = work->fn(work->argv);
+}
+
+static void after_work_cb(uv_work_t *req, int status) {
+    work_req_t *work = (work_req_t *)uv_req_get_data(requester(req));
+    if (work->is_abandoned) {
+        work_release(work);
+        return;
+    }
+
+    work->status = status;
+    work->is_done = true;
+    task_unpark(work->context);
+}
+
+/* Detach `work` from its parked caller, which then returns without touching it again,
+`after_work_cb` releases it once `fn` returns. */
+static void work_expired(wheel_entry_t *entry) {
+    work_req_t *work = (work_req_t *)entry->data;
+    task_state_t *state = (task_state_t *)get_coro_data(work->context);
+    routine_t *co = work->context;
+    work->expiry = nullptr;
+    wheel_stop(entry);
+    work_abandon(work);
+
+    uv_log_error(UV_ETIMEDOUT);
+    state->working = nullptr;
+    task_unpark(co);
+}
+
+/* `queue_work()` with `release` called on a result produced after caller gave up. */
+static value_t work_queue(callable_t fn, func_t release, string owned, size_t n_args, va_list ap) {
+    value_t result = nil;
+    task_state_t *state;
+    work_req_t *work;
+    size_t i;
+    u32 timeout;
+    int r;
+    if (is_empty(fn))
+        return result;
+
+    work = try_calloc(1, sizeof(work_req_t) + n_args * sizeof(value_t));
+    work->fn = fn;
+    work->release = release;
+    work->owned = owned;
+    for (i = 0; i < n_args; i++)
+        work->argv[i].object = va_arg(ap, void_t);
+
+    uv_req_set_data(requester(&work->req), (void_t)work);
+    if (r = uv_queue_work(uv_coro_loop(), &work->req, work_cb, after_work_cb)) {
+        uv_log_error(r);
+        coro_err_set(coro_active(), r);
+        RAII_FREE(work->owned);
+        RAII_FREE(work);
+        return result;
+    }
+
+    /* if this coroutine is halted while parked, its scope cancels the work */
+    state = task_state();
+    state->working = work;
+    work->context = coro_active();
+    if (timeout = deadline_timeout(0))
+        work->expiry = wheel_start(timeout, work_expired, work);
+
+    while (state->working == work && !work->is_done)
+        task_park(state);
+
+    if (state->working != work) {
+        /* deadline passed, `work` now belongs to `after_work_cb` */
+        coro_err_set(coro_active(), UV_ETIMEDOUT);
+        return result;
+    }
+
+    state->working = nullptr;
+    if (!is_empty(work->expiry)) {
+        wheel_stop(work->expiry);
+        work->expiry = nullptr;
+    }
+
+    if (work->status < 0)
+        coro_err_set(coro_active(), work->status);
+    else
+        result = work->result;
+
+    RAII_FREE(work->owned);
+    RAII_FREE(work);
+    return result;
+}
+
+value_t queue_work(callable_t fn, size_t n_args, ...) {
+    value_t result;
+    va_list ap;
+
+    va_start(ap, n_args);
+    result = work_queue(fn, nullptr, nullptr, n_args, ap);
+    va_end(ap);
+    return result;
+}
+
+/* Like `queue_work()`, `release` frees a result left behind, `owned` the copies its arguments point into. */
+static value_t queue_work_release(callable_t fn, func_t release, string owned, size_t n_args, ...) {
+    value_t result;
+    va_list ap;
+
+    va_start(ap, n_args);
+    result = work_queue(fn, release, owned, n_args, ap);
+    va_end(ap);
+    return result;
+}
+
+uv_file fs_open(string_t path, int flags, int mode) {
+    fs_req_t *fs = fs_request(UV_FS_OPEN);
+    fs->path = path;
+    fs->flags = flags;
+    fs->mode = mode;
+
+    return (uv_file)fs_start(fs).integer;
+}
+
+int fs_unlink(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_UNLINK);
+    fs->path = path;
+
+    return fs_start(fs).integer;
+}
+
+int fs_mkdir(string_t path, int mode) {
+    fs_req_t *fs = fs_request(UV_FS_MKDIR);
+    fs->path = path;
+    fs->mode = (mode ? mode : 0755);
+
+    return fs_start(fs).integer;
+}
+
+int fs_rmdir(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_RMDIR);
+    fs->path = path;
+
+    return fs_start(fs).integer;
+}
+
+int fs_rename(string_t path, string_t new_path) {
+    fs_req_t *fs = fs_request(UV_FS_RENAME);
+    fs->path = path;
+    fs->new_path = new_path;
+
+    return fs_start(fs).integer;
+}
+
+int fs_link(string_t path, string_t new_path) {
+    fs_req_t *fs = fs_request(UV_FS_LINK);
+    fs->path = path;
+    fs->new_path = new_path;
+
+    return fs_start(fs).integer;
+}
+
+scandir_t *fs_scandir(string_t path, int flags) {
+    fs_req_t *fs = fs_request(UV_FS_SCANDIR);
+    fs->path = path;
+    fs->flags = flags;
+
+    return (scandir_t *)fs_start(fs).object;
+}
+
+uv_dirent_t *fs_scandir_next(scandir_t *dir) {
+    if (!dir->started) {
+        dir->started = true;
+        client_defer((func_t)fs_cleanup, dir->req);
+    }
+
+    if (UV_EOF != uv_fs_scandir_next(dir->req, dir->item))
+        return dir->item;
+
+    return nullptr;
+}
+
+uv_stat_t *fs_fstat(uv_file fd) {
+    fs_req_t *fs = fs_request(UV_FS_FSTAT);
+    fs->fd = fd;
+    fs->result = client_calloc(1, sizeof(uv_stat_t));
+
+    return (uv_stat_t *)fs_start(fs).object;
+}
+
+int fs_fsync(uv_file fd) {
+    fs_req_t *fs = fs_request(UV_FS_FSYNC);
+    fs->fd = fd;
+
+    return fs_start(fs).integer;
+}
+
+int fs_fdatasync(uv_file fd) {
+    fs_req_t *fs = fs_request(UV_FS_FDATASYNC);
+    fs->fd = fd;
+
+    return fs_start(fs).integer;
+}
+
+int fs_ftruncate(uv_file fd, int64_t offset) {
+    fs_req_t *fs = fs_request(UV_FS_FTRUNCATE);
+    fs->fd = fd;
+    fs->offset = offset;
+
+    return fs_start(fs).integer;
+}
+
+int fs_fchmod(uv_file fd, int mode) {
+    fs_req_t *fs = fs_request(UV_FS_FCHMOD);
+    fs->fd = fd;
+    fs->mode = mode;
+
+    return fs_start(fs).integer;
+}
+
+int fs_fchown(uv_file fd, uv_uid_t uid, uv_gid_t gid) {
+    fs_req_t *fs = fs_request(UV_FS_FCHOWN);
+    fs->fd = fd;
+    fs->uid = uid;
+    fs->gid = gid;
+
+    return fs_start(fs).integer;
+}
+
+int fs_futime(uv_file fd, double atime, double mtime) {
+    fs_req_t *fs = fs_request(UV_FS_FUTIME);
+    fs->fd = fd;
+    fs->atime = atime;
+    fs->mtime = mtime;
+
+    return fs_start(fs).integer;
+}
+
+int fs_chmod(string_t path, int mode) {
+    fs_req_t *fs = fs_request(UV_FS_CHMOD);
+    fs->path = path;
+    fs->mode = mode;
+
+    return fs_start(fs).integer;
+}
+
+int fs_utime(string_t path, double atime, double mtime) {
+    fs_req_t *fs = fs_request(UV_FS_UTIME);
+    fs->path = path;
+    fs->atime = atime;
+    fs->mtime = mtime;
+
+    return fs_start(fs).integer;
+}
+
+int fs_lutime(string_t path, double atime, double mtime) {
+    fs_req_t *fs = fs_request(UV_FS_LUTIME);
+    fs->path = path;
+    fs->atime = atime;
+    fs->mtime = mtime;
+
+    return fs_start(fs).integer;
+}
+
+int fs_chown(string_t path, uv_uid_t uid, uv_gid_t gid) {
+    fs_req_t *fs = fs_request(UV_FS_CHOWN);
+    fs->path = path;
+    fs->uid = uid;
+    fs->gid = gid;
+
+    return fs_start(fs).integer;
+}
+
+int fs_lchown(string_t path, uv_uid_t uid, uv_gid_t gid) {
+    fs_req_t *fs = fs_request(UV_FS_LCHOWN);
+    fs->path = path;
+    fs->uid = uid;
+    fs->gid = gid;
+
+    return fs_start(fs).integer;
+}
+
+int fs_sendfile(uv_file out_fd, uv_file in_fd, int64_t in_offset, size_t length) {
+    fs_req_t *fs = fs_request(UV_FS_SENDFILE);
+    fs->fd = out_fd;
+    fs->in_fd = in_fd;
+    fs->offset = in_offset;
+    fs->length = length;
+
+    return fs_start(fs).integer;
+}
+
+int fs_access(string_t path, int mode) {
+    fs_req_t *fs = fs_request(UV_FS_ACCESS);
+    fs->path = path;
+    fs->mode = mode;
+
+    return fs_start(fs).integer;
+}
+
+int fs_copyfile(string_t path, string_t new_path, int flags) {
+    fs_req_t *fs = fs_request(UV_FS_COPYFILE);
+    fs->path = path;
+    fs->new_path = new_path;
+    fs->flags = flags;
+
+    return fs_start(fs).integer;
+}
+
+int fs_symlink(string_t path, string_t new_path, int flags) {
+    fs_req_t *fs = fs_request(UV_FS_SYMLINK);
+    fs->path = path;
+    fs->new_path = new_path;
+    fs->flags = flags;
+
+    return fs_start(fs).integer;
+}
+
+int fs_readlink(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_READLINK);
+    fs->path = path;
+
+    return fs_start(fs).integer;
+}
+
+int fs_realpath(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_REALPATH);
+    fs->path = path;
+
+    return fs_start(fs).integer;
+}
+
+uv_stat_t *fs_stat(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_STAT);
+    fs->path = path;
+    fs->result = client_calloc(1, sizeof(uv_stat_t));
+
+    return (uv_stat_t *)fs_start(fs).object;
+}
+
+uv_stat_t *fs_lstat(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_LSTAT);
+    fs->path = path;
+    fs->result = client_calloc(1, sizeof(uv_stat_t));
+
+    return (uv_stat_t *)fs_start(fs).object;
+}
+
+uv_statfs_t *fs_statfs(string_t path) {
+    fs_req_t *fs = fs_request(UV_FS_STATFS);
+    fs->path = path;
+    fs->result = client_calloc(1, sizeof(uv_statfs_t));
+
+    return (uv_statfs_t *)fs_start(fs).object;
+}
+
+uv_file fs_mkstemp(string_t tpl) {
+    fs_req_t *fs = fs_request(UV_FS_MKSTEMP);
+    fs->path = tpl;
+
+    return (uv_file)fs_start(fs).integer;
+}
+
+int fs_mkdtemp(string_t tpl) {
+    fs_req_t *fs = fs_request(UV_FS_MKDTEMP);
+    fs->path = tpl;
+
+    return fs_start(fs).integer;
+}
+
+RAII_INLINE bool fs_exists(string_t path) {
+    return fs_access(path, F_OK) == 0;
+}
+
+RAII_INLINE size_t fs_filesize(string_t path) {
+    uv_stat_t *stat = fs_stat(path);
+    if (!is_empty(stat))
+        return (size_t)stat->st_size;
+
+    return 0;
+}
+
+string fs_read(uv_file fd, int64_t offset) {
+    uv_stat_t *stat = fs_fstat(fd);
+    size_t sz = (size_t)stat->st_size;
+    fs_req_t *fs = fs_request(UV_FS_READ);
+
+    fs->fd = fd;
+    fs->offset = offset;
+    /* submitted directly, result is handed back without a copy and freed with the caller's scope */
+    fs->bufs = uv_buf_init(try_calloc(1, sz + 1), (unsigned int)sz);
+
+    return fs_start(fs).char_ptr;
+}
+
+#if !defined(_WIN32)
+/* Runs on the threadpool, result handed back through `queue_work()`. */
+static void_t fs_mmap_work(params_t args) {
+    string_t path = args[0].char_ptr;
+    int flags = (int)args[1].ulong_long, fd;
+    fs_mmap_t *map = RAII_CALLOC(1, sizeof(fs_mmap_t));
+    size_t i, page = (size_t)sysconf(_SC_PAGESIZE);
+    volatile char touched = 0;
+    struct stat st;
+    void_t addr;
+
+    map->type = UV_CORO_MMAP;
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+        map->status = uv_translate_sys_error(errno);
+        return map;
+    }
+
+    if (fstat(fd, &st)) {
+        map->status = uv_translate_sys_error(errno);
+    } else if (map->length = (size_t)st.st_size) {
+        addr = mmap(nullptr, map->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            map->status = uv_translate_sys_error(errno);
+            map->length = 0;
+        } else {
+            if (flags & FS_MMAP_SEQUENTIAL)
+                madvise(addr, map->length, MADV_SEQUENTIAL);
+            else if (flags & FS_MMAP_RANDOM)
+                madvise(addr, map->length, MADV_RANDOM);
+
+            if (flags & FS_MMAP_WILLNEED)
+                madvise(addr, map->length, MADV_WILLNEED);
+
+            if (flags & FS_MMAP_PREFAULT) {
+                for (i = 0; i < map->length; i += page)
+                    touched += ((volatile char *)addr)[i];
+            }
+
+            map->data = (string_t)addr;
+        }
+    }
+
+    close(fd);
+    return map;
+}
+
+static void fs_munmap(fs_mmap_t *map) {
+    if (map->length)
+        munmap((void_t)map->data, map->length);
+
+    map->type = RAII_ERR;
+    RAII_FREE(map);
+}
+#endif
+
+fs_mmap_t *fs_mmap(string_t path, int flags) {
+#if !defined(_WIN32)
+    fs_mmap_t *map;
+    string copy;
+    int r;
+    if (is_empty((void_t)path))
+        return nullptr;
+
+    copy = work_copy(path, nullptr, 0);
+    if (is_empty(map = (fs_mmap_t *)queue_work_release(fs_mmap_work, (func_t)fs_munmap, copy,
+                                                        2, copy, (size_t)flags).object))
+        return nullptr;
+
+    if (r = map->status) {
+        uv_log_error(r);
+        coro_err_set(coro_active(), r);
+        fs_munmap(map);
+        return nullptr;
+    }
+
+    client_defer((func_t)fs_munmap, map);
+    return map;
+#else
+    coro_err_set(coro_active(), UV_ENOTSUP);
+    return nullptr;
+#endif
+}
+
+static void fs_reader_ahead(fs_reader_t *reader) {
+    fs_req_t *fs = fs_request(UV_FS_READ);
+    int r;
+
+    fs->fd = reader->fd;
+    fs->offset = -1;
+    fs->bufs = uv_buf_init(reader->buffers[!reader->current], (unsigned int)reader->chunk_size);
+    fs->is_direct = true;
+    fs->context = coro_active();
+    if (r = fs_submit(fs)) {
+        uv_log_error(r);
+        uv_fs_req_cleanup(&fs->req);
+        fs_request_free(fs);
+        reader->status = r;
+        return;
+    }
+
+    reader->ahead = fs;
+}
+
+static void fs_reader_free(fs_reader_t *reader) {
+    fs_req_t *fs = reader->ahead;
+    int handed = 2;
+    if (!is_empty(fs)) {
+        if (fs->is_done) {
+            fs_cleanup(&fs->req);
+        } else {
+            /* still reading, `fs_cb` frees that buffer once it lands */
+            if (!fs->is_abandoned)
+                fs_abandon(fs);
+
+            handed = !reader->current;
+        }
+    }
+
+    if (handed != 0)
+        RAII_FREE(reader->buffers[0]);
+
+    if (handed != 1)
+        RAII_FREE(reader->buffers[1]);
+
+    reader->type = RAII_ERR;
+    RAII_FREE(reader);
+}
+
+fs_reader_t *fs_reader(uv_file fd, size_t chunk_size) {
+    fs_reader_t *reader = try_calloc(1, sizeof(fs_reader_t));
+    reader->type = UV_CORO_FS_READER;
+    reader->fd = fd;
+    reader->chunk_size = chunk_size ? chunk_size : Kb(64);
+    reader->buffers[0] = try_malloc(reader->chunk_size + 1);
+    reader->buffers[1] = try_malloc(reader->chunk_size + 1);
+    client_defer((func_t)fs_reader_free, reader);
+
+    return reader;
+}
+
+ssize_t fs_reader_next(fs_reader_t *reader, string_t *chunk) {
+    task_state_t *state;
+    fs_req_t *fs;
+    ssize_t nread;
+    if (!is_type(reader, UV_CORO_FS_READER) || is_empty(chunk))
+        return UV_EINVAL;
+
+    *chunk = nullptr;
+    if (is_empty(reader->ahead) && !reader->status)
+        fs_reader_ahead(reader);
+
+    if (is_empty(fs = reader->ahead))
+        return reader->status;
+
+    /* if this coroutine is halted while parked, its scope abandons the read */
+    state = task_state();
+    state->inflight = fs;
+    while (!fs->is_done)
+        task_park(state);
+
+    state->inflight = nullptr;
+    reader->ahead = nullptr;
+    if (fs->is_abandoned)
+        return reader->status = UV_ECANCELED;
+
+    nread = fs->status;
+    fs_cleanup(&fs->req);
+    if (nread <= 0) {
+        /* end of file, or error, stays that way */
+        reader->status = (int)nread;
+        return nread;
+    }
+
+    reader->current = !reader->current;
+    reader->buffers[reader->current][nread] = '\0';
+    *chunk = reader->buffers[reader->current];
+    fs_reader_ahead(reader);
+
+    return nread;
+}
+
+#if defined(UV_CORO_URING)
+static void_t uring_map(int fd, size_t size, off_t offset) {
+    void_t ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+static bool uring_supports(int fd) {
+    static const int needed[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE};
+    struct io_uring_probe *probe = try_calloc(1, sizeof(struct io_uring_probe)
+                                              + IORING_OP_LAST * sizeof(struct io_uring_probe_op));
+    bool is_supported = !syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+    int i;
+
+    for (i = 0; is_supported && i < (int)(sizeof(needed) / sizeof(needed[0])); i++)
+        is_supported = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+
+    RAII_FREE(probe);
+    return is_supported;
+}
+
+static void uring_prep(uring_t *ring, fs_batch_op_t *op, bool is_linked);
+/* Open and close "." through a direct descriptor slot, as chains do, kernels before 5.15
+fail one or both. */
+static bool uring_direct(uring_t *ring) {
+    fs_batch_op_t ops[2];
+    struct io_uring_cqe *cqe;
+    bool is_supported = true;
+    unsigned head;
+    int r;
+
+    memset(ops, 0, sizeof(ops));
+    ops[0].fs_type = UV_FS_OPEN;
+    ops[0].path = ".";
+    ops[0].flags = O_RDONLY | O_DIRECTORY;
+    ops[0].is_head = true;
+    ops[0].head = -1;
+    ops[1].fs_type = UV_FS_CLOSE;
+    uring_prep(ring, &ops[0], true);
+    uring_prep(ring, &ops[1], false);
+    __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+    do {
+        r = (int)syscall(__NR_io_uring_enter, ring->fd, 2, 2, IORING_ENTER_GETEVENTS, nullptr, 0);
+    } while (r < 0 && errno == EINTR);
+
+    if (r != 2)
+        return false;
+
+    head = *ring->cq_head;
+    for (; head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE); head++) {
+        cqe = &ring->cqes[head & *ring->cq_mask];
+        if (cqe->res < 0)
+            is_supported = false;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return is_supported;
+}
+
+/* Ring of this loop, set up on first use. Chains need direct descriptors, probed by
+`uring_direct()`, without them every batch goes to the threadpool. */
+static uring_t *uring_get(void) {
+    loop_data_t *data = uv_loop_data();
+    struct io_uring_params params;
+    uring_t *ring;
+    int i, fds[URING_FILES];
+    if (!uv_coro_uring)
+        return nullptr;
+
+    if (data->uring_status)
+        return data->uring;
+
+    data->uring_status = UV_ENOSYS;
+    memset(&params, 0, sizeof(params));
+    ring = try_calloc(1, sizeof(uring_t));
+    if ((ring->fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params)) < 0) {
+        RAII_FREE(ring);
+        return nullptr;
+    }
+
+    ring->entries = params.sq_entries;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size)
+            ring->sq_size = ring->cq_size;
+
+        ring->sq_ring = ring->cq_ring = uring_map(ring->fd, ring->sq_size, IORING_OFF_SQ_RING);
+    } else {
+        ring->sq_ring = uring_map(ring->fd, ring->sq_size, IORING_OFF_SQ_RING);
+        ring->cq_ring = uring_map(ring->fd, ring->cq_size, IORING_OFF_CQ_RING);
+    }
+
+    ring->sqes = uring_map(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+    for (i = 0; i < URING_FILES; i++) {
+        fds[i] = -1;
+        ring->slots[i] = i;
+    }
+
+    ring->free_slots = URING_FILES;
+    if (is_empty(ring->sq_ring) || is_empty(ring->cq_ring) || is_empty(ring->sqes)) {
+        uring_free(ring);
+        return nullptr;
+    }
+
+    ring->sq_head = (unsigned *)((char *)ring->sq_ring + params.sq_off.head);
+    ring->sq_ktail = (unsigned *)((char *)ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)((char *)ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((char *)ring->sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned *)((char *)ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *)((char *)ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)((char *)ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((char *)ring->cq_ring + params.cq_off.cqes);
+    ring->sq_tail = *ring->sq_ktail;
+    if (!uring_supports(ring->fd)
+        || syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, fds, URING_FILES)
+        || !uring_direct(ring) || uv_poll_init(uv_coro_loop(), &ring->poll, ring->fd)) {
+        uring_free(ring);
+        return nullptr;
+    }
+
+    uv_handle_set_data(handler(&ring->poll), ring);
+
+    data->uring_status = 1;
+    return data->uring = ring;
+}
+
+static void uring_prep(uring_t *ring, fs_batch_op_t *op, bool is_linked) {
+    unsigned index = ring->sq_tail++ & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    bool is_fixed = op->head >= 0;
+
+    ring->sq_array[index] = index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    sqe->fd = is_fixed ? op->slot : op->fd;
+    if (is_fixed && op->fs_type != UV_FS_CLOSE)
+        sqe->flags |= IOSQE_FIXED_FILE;
+
+    /* hard links keep going after a failure, so the chain's close always runs */
+    if (is_linked)
+        sqe->flags |= IOSQE_IO_HARDLINK;
+
+    switch (op->fs_type) {
+        case UV_FS_OPEN:
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)op->path;
+            sqe->len = (unsigned)op->mode;
+            if (op->is_head) {
+                sqe->open_flags = (unsigned)op->flags;
+                sqe->file_index = op->slot + 1;
+            } else {
+                sqe->open_flags = (unsigned)(op->flags | O_CLOEXEC);
+            }
+            break;
+        case UV_FS_STAT:
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)op->path;
+            sqe->len = STATX_BASIC_STATS | STATX_BTIME;
+            sqe->off = (uint64_t)(uintptr_t)(op->stat + 1);
+            break;
+        case UV_FS_READ:
+        case UV_FS_WRITE:
+            sqe->opcode = op->fs_type == UV_FS_READ ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->addr = (uint64_t)(uintptr_t)op->buf.base;
+            sqe->len = (unsigned)op->buf.len;
+            sqe->off = (uint64_t)op->offset;
+            break;
+        case UV_FS_CLOSE:
+            sqe->opcode = IORING_OP_CLOSE;
+            if (is_fixed) {
+                sqe->fd = 0;
+                sqe->file_index = op->slot + 1;
+            }
+            break;
+        default:
+            sqe->opcode = IORING_OP_NOP;
+            break;
+    }
+}
+
+static void uring_statx(uv_stat_t *stat) {
+    struct statx *stx = (struct statx *)(stat + 1);
+    stat->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    stat->st_mode = stx->stx_mode;
+    stat->st_nlink = stx->stx_nlink;
+    stat->st_uid = stx->stx_uid;
+    stat->st_gid = stx->stx_gid;
+    stat->st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    stat->st_ino = stx->stx_ino;
+    stat->st_size = stx->stx_size;
+    stat->st_blksize = stx->stx_blksize;
+    stat->st_blocks = stx->stx_blocks;
+    stat->st_atim.tv_sec = stx->stx_atime.tv_sec;
+    stat->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+    stat->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    stat->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+    stat->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+    stat->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+    stat->st_birthtim.tv_sec = stx->stx_btime.tv_sec;
+    stat->st_birthtim.tv_nsec = stx->stx_btime.tv_nsec;
+    stat->st_flags = 0;
+    stat->st_gen = 0;
+}
+
+static void fs_batch_done(fs_batch_op_t *op);
+static void uring_reap(uring_t *ring) {
+    unsigned head = *ring->cq_head, tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+    fs_batch_op_t *op;
+
+    for (; head != tail; head++) {
+        cqe = &ring->cqes[head & *ring->cq_mask];
+        op = (fs_batch_op_t *)(uintptr_t)cqe->user_data;
+        op->result = cqe->res;
+        if (op->fs_type == UV_FS_STAT && !op->result)
+            uring_statx(op->stat);
+        else if (op->fs_type == UV_FS_CLOSE && op->head >= 0)
+            ring->slots[ring->free_slots++] = op->slot;
+
+        ring->inflight--;
+        fs_batch_done(op);
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    if (!ring->inflight)
+        uv_poll_stop(&ring->poll);
+}
+
+static void uring_cb(uv_poll_t *handle, int status, int events) {
+    uring_reap((uring_t *)uv_handle_get_data(handler(handle)));
+}
+
+static int uring_submit(uring_t *ring) {
+    unsigned count;
+    int r;
+
+    __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+    count = ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    do {
+        r = (int)syscall(__NR_io_uring_enter, ring->fd, count, 0, 0, nullptr, 0);
+    } while (r < 0 && errno == EINTR);
+
+    if (ring->inflight && !uv_is_active(handler(&ring->poll)))
+        uv_poll_start(&ring->poll, UV_READABLE, uring_cb);
+
+    return r < 0 && errno != EAGAIN && errno != EBUSY ? uv_translate_sys_error(errno) : 0;
+}
+#endif
+
+static void fs_batch_free(fs_batch_t *batch) {
+    size_t i;
+    if (!is_empty(batch->expiry)) {
+        wheel_stop(batch->expiry);
+        batch->expiry = nullptr;
+    }
+
+    batch->context = nullptr;
+    if (batch->pending) {
+        /* still running, last completion releases it */
+        batch->is_abandoned = true;
+        return;
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        if (batch->ops[i].fs_type == UV_FS_READ)
+            RAII_FREE(batch->ops[i].buf.base);
+        else if (batch->ops[i].fs_type == UV_FS_STAT)
+            RAII_FREE(batch->ops[i].stat);
+
+        RAII_FREE(batch->ops[i].copy);
+    }
+
+    RAII_FREE(batch->ops);
+    batch->type = RAII_ERR;
+    RAII_FREE(batch);
+}
+
+static void fs_batch_done(fs_batch_op_t *op) {
+    fs_batch_t *batch = op->batch;
+    if (op->head >= 0 && batch->ops[op->head].result < 0)
+        op->result = UV_ECANCELED;
+    else if (op->is_head && op->result > 0)
+        /* threadpool descriptor, already closed by its chain */
+        op->result = 0;
+    else if (op->fs_type == UV_FS_READ && op->result >= 0)
+        op->buf.base[op->result] = '\0';
+
+    op->is_done = true;
+    if (!--batch->pending && batch->is_abandoned)
+        fs_batch_free(batch);
+    else if (!batch->pending || batch->next < batch->count)
+        /* all done, or room to submit what waits */
+        task_unpark(batch->context);
+}
+
+/* Runs on the threadpool, chained operations use the descriptor their `open` returned. */
+static void fs_batch_work(uv_work_t *req) {
+    fs_batch_unit_t *unit = (fs_batch_unit_t *)uv_req_get_data(requester(req));
+    fs_batch_op_t *op, *ops = unit->ops;
+    uv_file fd;
+    uv_fs_t fs;
+    size_t i;
+
+    for (i = 0; i < unit->count; i++) {
+        op = &ops[i];
+        fd = op->fd;
+        if (op->head >= 0) {
+            /* a chain is always its own unit, headed by its `open` */
+            if (ops[0].result < 0) {
+                op->result = UV_ECANCELED;
+                continue;
+            }
+
+            fd = (uv_file)ops[0].result;
+        }
+
+        switch (op->fs_type) {
+            case UV_FS_OPEN:
+                op->result = uv_fs_open(unit->loop, &fs, op->path, op->flags, op->mode, nullptr);
                 break;
-            case UV_FS_FCHOWN:
-                result = uv_fs_fchown(uvLoop, req, fd, (uv_uid_t)args[1].uchar, (uv_uid_t)args[2].uchar, fs_cb);
+            case UV_FS_STAT:
+                if (!(op->result = uv_fs_stat(unit->loop, &fs, op->path, nullptr)))
+                    memcpy(op->stat, uv_fs_get_statbuf(&fs), sizeof(uv_stat_t));
                 break;
             case UV_FS_READ:
-                result = uv_fs_read(uvLoop, req, fd, &fs->bufs, 1, args[1].long_long, fs_cb);
+                op->result = uv_fs_read(unit->loop, &fs, fd, &op->buf, 1, op->offset, nullptr);
                 break;
             case UV_FS_WRITE:
-                result = uv_fs_write(uvLoop, req, fd, &fs->bufs, 1, args[1].long_long, fs_cb);
+                op->result = uv_fs_write(unit->loop, &fs, fd, &op->buf, 1, op->offset, nullptr);
+                break;
+            case UV_FS_CLOSE:
+                op->result = uv_fs_close(unit->loop, &fs, fd, nullptr);
                 break;
-            case UV_FS_UNKNOWN:
-            case UV_FS_CUSTOM:
             default:
-                fprintf(stderr, "type; %d not supported.\033[0K\n", fs->fs_type);
+                op->result = UV_ENOTSUP;
+                continue;
+        }
+
+        uv_fs_req_cleanup(&fs);
+    }
+}
+
+static void fs_batch_after(uv_work_t *req, int status) {
+    fs_batch_unit_t *unit = (fs_batch_unit_t *)uv_req_get_data(requester(req));
+    size_t i;
+
+    for (i = 0; i < unit->count; i++) {
+        if (status == UV_ECANCELED)
+            unit->ops[i].result = UV_ECANCELED;
+
+        fs_batch_done(&unit->ops[i]);
+    }
+
+    RAII_FREE(unit);
+}
+
+/* Operations from `first` that have to go together, an `open` with its chain, or just one. */
+static size_t fs_batch_span(fs_batch_t *batch, size_t first) {
+    size_t count = 1;
+    if (batch->ops[first].is_head) {
+        while (first + count < batch->count && batch->ops[first + count].head == (int)first)
+            count++;
+    }
+
+    return count;
+}
+
+static int fs_batch_queue(fs_batch_t *batch, size_t count) {
+    fs_batch_unit_t *unit = try_calloc(1, sizeof(fs_batch_unit_t));
+    int r;
+
+    unit->loop = uv_coro_loop();
+    unit->ops = &batch->ops[batch->next];
+    unit->count = count;
+    uv_req_set_data(requester(&unit->req), (void_t)unit);
+    if (r = uv_queue_work(unit->loop, &unit->req, fs_batch_work, fs_batch_after)) {
+        RAII_FREE(unit);
+        return r;
+    }
+
+    batch->pending += count;
+    batch->next += count;
+    return 0;
+}
+
+static void fs_batch_submit(fs_batch_t *batch) {
+    size_t count;
+    int r = 0;
+#if defined(UV_CORO_URING)
+    uring_t *ring = uring_get();
+    size_t i;
+    int slot;
+
+    if (!is_empty(ring)) {
+        while (!r && batch->next < batch->count) {
+            count = fs_batch_span(batch, batch->next);
+            if (count > ring->entries) {
+                /* never fits the ring */
+                r = fs_batch_queue(batch, count);
+                continue;
+            }
+
+            /* ring full, or out of file slots, the rest waits for completions,
+            or takes the threadpool if none of them are ours to wake us */
+            if (ring->inflight + count > ring->entries
+                || (batch->ops[batch->next].is_head && !ring->free_slots)) {
+                if (!batch->pending)
+                    r = fs_batch_queue(batch, count);
+
+                break;
+            }
+
+            slot = batch->ops[batch->next].is_head ? ring->slots[--ring->free_slots] : -1;
+            for (i = 0; i < count; i++) {
+                batch->ops[batch->next + i].slot = slot;
+                uring_prep(ring, &batch->ops[batch->next + i], i + 1 < count);
+            }
+
+            ring->inflight += (unsigned)count;
+            batch->pending += count;
+            batch->next += count;
+        }
+
+        if (!r)
+            r = uring_submit(ring);
+    } else
+#endif
+    while (!r && batch->next < batch->count) {
+        count = fs_batch_span(batch, batch->next);
+        if (!batch->ops[batch->next].is_head) {
+            /* unchained operations share a thread hop */
+            while (count < FS_BATCH_GROUP && batch->next + count < batch->count
+                   && !batch->ops[batch->next + count].is_head)
+                count++;
+        }
+
+        r = fs_batch_queue(batch, count);
+    }
+
+    if (r) {
+        uv_log_error(r);
+        batch->status = r;
+    }
+}
+
+static void fs_batch_expired(wheel_entry_t *entry) {
+    fs_batch_t *batch = (fs_batch_t *)entry->data;
+    batch->expiry = nullptr;
+    wheel_stop(entry);
+
+    uv_log_error(UV_ETIMEDOUT);
+    batch->status = UV_ETIMEDOUT;
+    task_unpark(batch->context);
+}
+
+static int fs_batch_add(fs_batch_t *batch, uv_fs_type fs_type, uv_file fd);
+/* Ends the chain being queued, closing its file if nothing did. */
+static void fs_batch_seal(fs_batch_t *batch) {
+    if (batch->chain >= 0 && batch->ops[batch->chain].is_head)
+        fs_batch_add(batch, UV_FS_CLOSE, FS_BATCH_FD);
+
+    batch->chain = -1;
+}
+
+static int fs_batch_add(fs_batch_t *batch, uv_fs_type fs_type, uv_file fd) {
+    fs_batch_op_t *op, *ops;
+    size_t capacity;
+    if (!is_type(batch, UV_CORO_FS_BATCH) || batch->is_awaiting)
+        return UV_EINVAL;
+
+    if (fd != FS_BATCH_FD)
+        fs_batch_seal(batch);
+    else if (batch->chain < 0)
+        return UV_EBADF;
+
+    if (batch->count == batch->capacity) {
+        capacity = batch->capacity ? batch->capacity * 2 : 16;
+        ops = try_malloc(capacity * sizeof(fs_batch_op_t));
+        if (batch->count)
+            memcpy(ops, batch->ops, batch->count * sizeof(fs_batch_op_t));
+
+        RAII_FREE(batch->ops);
+        batch->ops = ops;
+        batch->capacity = capacity;
+    }
+
+    op = &batch->ops[batch->count];
+    memset(op, 0, sizeof(fs_batch_op_t));
+    op->batch = batch;
+    op->fs_type = fs_type;
+    op->fd = fd;
+    op->head = -1;
+    op->slot = -1;
+    op->offset = -1;
+    if (fd == FS_BATCH_FD) {
+        op->head = batch->chain;
+        batch->ops[batch->chain].is_head = true;
+        if (fs_type == UV_FS_CLOSE)
+            batch->chain = -1;
+    } else if (fs_type == UV_FS_OPEN) {
+        batch->chain = (int)batch->count;
+    }
+
+    return (int)batch->count++;
+}
+
+fs_batch_t *fs_batch(void) {
+    fs_batch_t *batch = try_calloc(1, sizeof(fs_batch_t));
+    batch->type = UV_CORO_FS_BATCH;
+    batch->chain = -1;
+    client_defer((func_t)fs_batch_free, batch);
+
+    return batch;
+}
+
+/* Batch owned copy of `length` bytes of `data`, a passed deadline returns from
+`fs_batch_await()` with operations still running on it. */
+static string fs_batch_copy(fs_batch_op_t *op, string_t data, size_t length) {
+    op->copy = try_malloc(length ? length : 1);
+    memcpy(op->copy, data, length);
+
+    return op->copy;
+}
+
+int fs_batch_open(fs_batch_t *batch, string_t path, int flags, int mode) {
+    int index = fs_batch_add(batch, UV_FS_OPEN, INVALID_FD);
+    if (index >= 0) {
+        batch->ops[index].path = fs_batch_copy(&batch->ops[index], path, strlen(path) + 1);
+        batch->ops[index].flags = flags;
+        batch->ops[index].mode = mode;
+    }
+
+    return index;
+}
+
+int fs_batch_stat(fs_batch_t *batch, string_t path) {
+    int index = fs_batch_add(batch, UV_FS_STAT, INVALID_FD);
+    if (index >= 0) {
+        batch->ops[index].path = fs_batch_copy(&batch->ops[index], path, strlen(path) + 1);
+        batch->ops[index].stat = try_calloc(1, FS_BATCH_STAT_SIZE);
+    }
+
+    return index;
+}
+
+int fs_batch_read(fs_batch_t *batch, uv_file fd, size_t size, int64_t offset) {
+    int index = fs_batch_add(batch, UV_FS_READ, fd);
+    if (index >= 0) {
+        batch->ops[index].offset = offset;
+        batch->ops[index].buf = uv_buf_init(try_malloc(size + 1), (unsigned int)size);
+    }
+
+    return index;
+}
+
+int fs_batch_write(fs_batch_t *batch, uv_file fd, string_t data, size_t size, int64_t offset) {
+    int index = fs_batch_add(batch, UV_FS_WRITE, fd);
+    if (index >= 0) {
+        batch->ops[index].offset = offset;
+        batch->ops[index].buf = uv_buf_init(fs_batch_copy(&batch->ops[index], data, size), (unsigned int)size);
+    }
+
+    return index;
+}
+
+RAII_INLINE int fs_batch_close(fs_batch_t *batch, uv_file fd) {
+    return fs_batch_add(batch, UV_FS_CLOSE, fd);
+}
+
+int fs_batch_readfile(fs_batch_t *batch, string_t path, size_t max_size) {
+    int index = fs_batch_open(batch, path, O_RDONLY, 0);
+    if (index >= 0 && (index = fs_batch_read(batch, FS_BATCH_FD, max_size, 0)) >= 0)
+        fs_batch_close(batch, FS_BATCH_FD);
+
+    return index;
+}
+
+int fs_batch_await(fs_batch_t *batch) {
+    task_state_t *state;
+    u32 timeout;
+    if (!is_type(batch, UV_CORO_FS_BATCH) || batch->is_awaiting)
+        return UV_EINVAL;
+
+    fs_batch_seal(batch);
+    batch->is_awaiting = true;
+    if (timeout = deadline_timeout(0))
+        batch->expiry = wheel_start(timeout, fs_batch_expired, batch);
+
+    state = task_state();
+    batch->context = coro_active();
+    while (!batch->status && (batch->next < batch->count || batch->pending)) {
+        if (batch->next < batch->count)
+            fs_batch_submit(batch);
+
+        if (!batch->status && batch->pending)
+            task_park(state);
+    }
+
+    batch->context = nullptr;
+
+    if (!is_empty(batch->expiry)) {
+        wheel_stop(batch->expiry);
+        batch->expiry = nullptr;
+    }
+
+    if (batch->status)
+        coro_err_set(coro_active(), batch->status);
+
+    return batch->status;
+}
+
+ssize_t fs_batch_result(fs_batch_t *batch, int index) {
+    if (!is_type(batch, UV_CORO_FS_BATCH) || index < 0 || (size_t)index >= batch->count)
+        return UV_EINVAL;
+
+    if (!batch->ops[index].is_done)
+        return UV_EAGAIN;
+
+    return batch->ops[index].result;
+}
+
+void_t fs_batch_data(fs_batch_t *batch, int index) {
+    fs_batch_op_t *op;
+    if (fs_batch_result(batch, index) < 0)
+        return nullptr;
+
+    op = &batch->ops[index];
+    if (op->fs_type == UV_FS_READ)
+        return op->buf.base;
+
+    if (op->fs_type == UV_FS_STAT)
+        return op->stat;
+
+    return nullptr;
+}
+
+int fs_write(uv_file fd, string_t text, int64_t offset) {
+    size_t size = simd_strlen(text);
+    fs_req_t *fs = fs_request(UV_FS_WRITE);
+
+    fs->fd = fd;
+    fs->offset = offset;
+    fs->bufs = uv_buf_init((string)text, (unsigned int)size);
+
+    return fs_start(fs).integer;
+}
+
+/* Caller's `bufs` are handed to `uv_fs_read()`/`uv_fs_write()` as they are, one
+`preadv()`/`pwritev()` on the threadpool, see `fs_submit()`. */
+static ssize_t fs_vector(uv_fs_type fs_type, uv_file fd, const uv_buf_t bufs[], unsigned int n, int64_t offset) {
+    fs_req_t *fs;
+    if (is_empty((void_t)bufs) || !n)
+        return UV_EINVAL;
+
+    fs = fs_request(fs_type);
+    fs->fd = fd;
+    fs->offset = offset;
+    fs->vbufs = bufs;
+    fs->nbufs = n;
+    return (ssize_t)fs_start(fs).long_long;
+}
+
+RAII_INLINE ssize_t fs_readv(uv_file fd, uv_buf_t bufs[], unsigned int n, int64_t offset) {
+    return fs_vector(UV_FS_READ, fd, bufs, n, offset);
+}
+
+RAII_INLINE ssize_t fs_writev(uv_file fd, const uv_buf_t bufs[], unsigned int n, int64_t offset) {
+    return fs_vector(UV_FS_WRITE, fd, bufs, n, offset);
+}
+
+int fs_close(uv_file fd) {
+    fs_req_t *fs = fs_request(UV_FS_CLOSE);
+    fs->fd = fd;
+
+    return fs_start(fs).integer;
+}
+
+/* Largest single read or write of a whole file job, `uv_buf_t` lengths and results stay in range. */
+#define FS_FILE_CHUNK ((size_t)INT_MAX)
+
+/* Result of a whole file job, bytes moved or error code, and contents read. */
+typedef struct fs_file_s {
+    ssize_t status;
+    string data;
+} fs_file_t;
+
+static void fs_file_free(fs_file_t *file) {
+    RAII_FREE(file->data);
+    RAII_FREE(file);
+}
+
+/* Runs on the threadpool, open, fstat, read and close as synchronous `uv_fs_*` calls. */
+static void_t fs_readfile_work(params_t args) {
+    uv_loop_t *loop = (uv_loop_t *)args[0].object;
+    fs_file_t *file = RAII_CALLOC(1, sizeof(fs_file_t));
+    size_t size = 0, total = 0;
+    ssize_t nread = 0;
+    uv_file fd;
+    uv_buf_t buf;
+    uv_fs_t req;
+
+    fd = uv_fs_open(loop, &req, args[1].char_ptr, O_RDONLY, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    if ((file->status = fd) < 0)
+        return file;
+
+    if (!(file->status = uv_fs_fstat(loop, &req, fd, nullptr)))
+        size = (size_t)uv_fs_get_statbuf(&req)->st_size;
+
+    uv_fs_req_cleanup(&req);
+    if (!file->status) {
+        file->data = RAII_CALLOC(1, size + 1);
+        while (total < size) {
+            buf = uv_buf_init(file->data + total,
+                              (unsigned int)(size - total > FS_FILE_CHUNK ? FS_FILE_CHUNK : size - total));
+            nread = uv_fs_read(loop, &req, fd, &buf, 1, (int64_t)total, nullptr);
+            uv_fs_req_cleanup(&req);
+            if (nread <= 0)
                 break;
+
+            total += (size_t)nread;
+        }
+
+        if (nread < 0) {
+            RAII_FREE(file->data);
+            file->data = nullptr;
+            file->status = nread;
+        } else {
+            file->data[total] = '\0';
+            file->status = (ssize_t)total;
+        }
+    }
+
+    uv_fs_close(loop, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    return file;
+}
+
+/* Fsync the directory holding `path`, so a rename into it survives a crash. */
+static int fs_syncdir(uv_loop_t *loop, string_t path) {
+    string_t slash = strrchr(path, '/');
+    size_t length = is_empty((void_t)slash) ? 0 : (size_t)(slash - path);
+    string dir = RAII_CALLOC(1, length + 2);
+    uv_file fd;
+    uv_fs_t req;
+    int r;
+
+    if (is_empty((void_t)slash))
+        dir[0] = '.';
+    else
+        memcpy(dir, path, length ? length : 1);
+
+    fd = uv_fs_open(loop, &req, dir, O_RDONLY, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    RAII_FREE(dir);
+    if (fd < 0)
+        return fd;
+
+    r = uv_fs_fsync(loop, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    uv_fs_close(loop, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    return r;
+}
+
+/* Runs on the threadpool, atomic replace goes through a `mkstemp()` file next to `path`,
+given the mode of the file it replaces. */
+static void_t fs_writefile_work(params_t args) {
+    uv_loop_t *loop = (uv_loop_t *)args[0].object;
+    string_t path = args[1].char_ptr;
+    string_t data = args[2].char_ptr;
+    size_t length = (size_t)args[3].ulong_long, total = 0;
+    int flags = (int)args[4].ulong_long, status = 0, r;
+    fs_file_t *file = RAII_CALLOC(1, sizeof(fs_file_t));
+    string temp = nullptr;
+    ssize_t nwritten;
+    uv_file fd;
+    uv_buf_t buf;
+    uv_fs_t req;
+
+    if (flags & FS_WRITE_ATOMIC) {
+        temp = RAII_CALLOC(1, strlen(path) + sizeof(".XXXXXX"));
+        strcat(strcpy(temp, path), ".XXXXXX");
+        if ((fd = uv_fs_mkstemp(loop, &req, temp, nullptr)) >= 0)
+            strcpy(temp, req.path);
+
+        uv_fs_req_cleanup(&req);
+        /* a new file keeps `mkstemp()` 0600, what the plain path creates too */
+        if (fd >= 0 && !uv_fs_stat(loop, &req, path, nullptr)) {
+            status = uv_fs_fchmod(loop, &req, fd, (int)(uv_fs_get_statbuf(&req)->st_mode & 07777), nullptr);
+            uv_fs_req_cleanup(&req);
+        }
+    } else {
+        fd = uv_fs_open(loop, &req, path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR, nullptr);
+    }
+
+    uv_fs_req_cleanup(&req);
+    if (fd < 0) {
+        RAII_FREE(temp);
+        file->status = fd;
+        return file;
+    }
+
+    while (!status && total < length) {
+        buf = uv_buf_init((string)data + total,
+                          (unsigned int)(length - total > FS_FILE_CHUNK ? FS_FILE_CHUNK : length - total));
+        nwritten = uv_fs_write(loop, &req, fd, &buf, 1, (int64_t)total, nullptr);
+        uv_fs_req_cleanup(&req);
+        if (nwritten <= 0) {
+            /* nothing written for a non empty buffer would only repeat forever */
+            status = nwritten ? (int)nwritten : UV_EIO;
+            break;
+        }
+
+        total += (size_t)nwritten;
+    }
+
+    if (!status && (flags & (FS_WRITE_SYNC | FS_WRITE_ATOMIC))) {
+        status = uv_fs_fdatasync(loop, &req, fd, nullptr);
+        uv_fs_req_cleanup(&req);
+    }
+
+    r = uv_fs_close(loop, &req, fd, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (!status)
+        status = r;
+
+    if (!is_empty(temp)) {
+        if (!status) {
+            status = uv_fs_rename(loop, &req, temp, path, nullptr);
+            uv_fs_req_cleanup(&req);
+            if (!status) {
+                /* `temp` is `path` now, only the directory entry is left to persist */
+                status = fs_syncdir(loop, path);
+                RAII_FREE(temp);
+                temp = nullptr;
+            }
+        }
+
+        if (!is_empty(temp)) {
+            uv_fs_unlink(loop, &req, temp, nullptr);
+            uv_fs_req_cleanup(&req);
+            RAII_FREE(temp);
+        }
+    }
+
+    file->status = status ? status : (ssize_t)total;
+    return file;
+}
+
+string fs_readfile(string_t path) {
+    fs_file_t *file;
+    string data = nullptr, copy;
+    if (is_empty((void_t)path))
+        return nullptr;
+
+    copy = work_copy(path, nullptr, 0);
+    if (is_empty(file = (fs_file_t *)queue_work_release(fs_readfile_work, (func_t)fs_file_free, copy,
+                                                        2, uv_coro_loop(), copy).object))
+        return nullptr;
+
+    if (file->status < 0) {
+        uv_log_error((int)file->status);
+        coro_err_set(coro_active(), (int)file->status);
+    } else {
+        data = file->data;
+        client_defer((func_t)RAII_FREE, data);
+    }
+
+    RAII_FREE(file);
+    return data;
+}
+
+int fs_writefile_buf(string_t path, string_t data, size_t length, int flags) {
+    fs_file_t *file;
+    string copy;
+    int status;
+    if (is_empty((void_t)path) || (is_empty((void_t)data) && length))
+        return UV_EINVAL;
+
+    /* the job can outlive this caller, give it path and contents of its own */
+    copy = work_copy(path, data, length);
+    if (is_empty(file = (fs_file_t *)queue_work_release(fs_writefile_work, (func_t)fs_file_free, copy,
+                                                        5, uv_coro_loop(), copy, copy + strlen(path) + 1,
+                                                        length, (size_t)flags).object))
+        return coro_err_code();
+
+    if ((status = (int)file->status) < 0) {
+        uv_log_error(status);
+        coro_err_set(coro_active(), status);
+    }
+
+    RAII_FREE(file);
+    return status;
+}
+
+RAII_INLINE int fs_writefile(string_t path, string_t text) {
+    return fs_writefile_buf(path, text, is_empty((void_t)text) ? 0 : simd_strlen(text), 0);
+}
+
+void fs_poll(string_t path, poll_cb pollfunc, int interval) {
+    uv_fs_poll_t *poll = fs_poll_create();
+    if (is_empty(poll))
+        raii_panic("Initialization failed: `fs_poll_create`");
+
+    uv_args_t *uv_args = uv_arguments(4, false);
+    $append(uv_args->args, poll);
+    $append_string(uv_args->args, str_dup(path));
+    $append_func(uv_args->args, pollfunc);
+    $append_signed(uv_args->args, interval);
+    coro_launch(coro_fs_poll, 1, uv_args);
+}
+
+void fs_watch(string_t path, event_cb watchfunc) {
+    uv_fs_event_t *event = fs_event_create();
+    if (is_empty(event))
+        raii_panic("Initialization failed: `fs_event_create`");
+
+    uv_args_t *uv_args = uv_arguments(3, false);
+    $append(uv_args->args, event);
+    $append_string(uv_args->args, str_dup(path));
+    $append_func(uv_args->args, watchfunc);
+    coro_launch(coro_fs_event, 1, uv_args);
+}
+
+dnsinfo_t *get_addrinfo(string_t address, string_t service, u32 numhints_pair, ...) {
+    uv_args_t *uv_args = uv_arguments(3, false);
+    ai_hints_types k;
+    int hint, i, count = 2;
+    va_list ap;
+    addrinfo_t *hints = nullptr;
+    $append_string(uv_args->args, address);
+    $append_string(uv_args->args, service);
+    if (numhints_pair > 0) {
+        hints = uv_args->dns->original;
+        va_start(ap, numhints_pair);
+        for (i = 0; i < numhints_pair; i++) {
+            k = va_arg(ap, ai_hints_types);
+            hint = va_arg(ap, int);
+            switch (k) {
+                case ai_family: hints->ai_family = hint; break;
+                case ai_socktype: hints->ai_socktype = hint; break;
+                case ai_protocol: hints->ai_protocol = hint; break;
+                case ai_flags: hints->ai_flags = hint; break;
+            }
+        }
+        va_end(ap);
+        $append(uv_args->args, hints);
+        count++;
+    }
+
+    return (dnsinfo_t *)uv_start(uv_args, UV_GETADDRINFO, count, true).object;
+}
+
+addrinfo_t *addrinfo_next(dnsinfo_t *dns) {
+    if (is_type(dns, UV_CORO_DNS) && !is_empty(dns->addr)) {
+        addrinfo_t *dir = dns->addr;
+        int ip = RAII_ERR;
+        *dns->original = *dns->addr;
+        if (dir->ai_canonname)
+            dns->ip_name = dir->ai_canonname;
+
+        if (dir->ai_family == AF_INET) {
+            if (is_zero(ip = uv_ip4_name((const struct sockaddr_in *)dir->ai_addr, dns->ip, INET_ADDRSTRLEN)))
+                dns->ip_addr = dns->ip;
+        } else if (dir->ai_family == AF_INET6) {
+            if (is_zero(ip = uv_ip6_name((const struct sockaddr_in6 *)dir->ai_addr, dns->ip, INET6_ADDRSTRLEN)))
+                dns->ip6_addr = dns->ip;
+        }
+
+        if (ip) {
+            uv_log_error(ip);
+            return nullptr;
+        }
+
+        dns->addr = dir->ai_next;
+        return  dns->addr;
+    }
+
+    return nullptr;
+}
+
+nameinfo_t *get_nameinfo(string_t addr, int port, int flags) {
+    uv_args_t *uv_args = uv_arguments(2, false);
+    void_t addr_set = uv_coro_sockaddr(addr, port, uv_args->dns->in6, uv_args->dns->in4);
+
+    if (!addr_set) {
+        $append(uv_args->args, addr_set);
+        $append_signed(uv_args->args, flags);
+        return (nameinfo_t *)uv_start(uv_args, UV_GETNAMEINFO, 2, true).object;
+    } else {
+        uv_arguments_free(uv_args);
+        return nullptr;
+    }
+}
+
+static void stream_serve(uv_stream_t *client, stream_cb handlerFunc) {
+    raii_type type = ((uv_args_t *)uv_handle_get_data(handler(client)))->bind_type;
+    uv_args_t *uv_args = uv_arguments(1, true);
+
+    $append(uv_args->args, client);
+    uv_args->bind_type = type;
+    uv_handle_set_data(handler(client), (void_t)uv_args);
+    if (type == RAII_SCHEME_TLS)
+        client_defer((func_t)tls_close_free, client);
+    else
+        client_defer((func_t)uv_close_free, client);
+
+    handlerFunc(client);
+    yield();
+}
+
+static void_t stream_client(params_t args) {
+    stream_serve((uv_stream_t *)args[0].object, (stream_cb)args[1].func);
+    return 0;
+}
+
+/* Park calling coroutine on `list` until `pool_wake()` takes it off. */
+static void pool_wait(pool_waiter_t **list) {
+    pool_waiter_t waiter;
+    waiter.co = coro_active();
+    waiter.next = *list;
+    *list = &waiter;
+    task_park(task_state());
+}
+
+static void pool_wake(pool_waiter_t **list) {
+    pool_waiter_t *waiter = *list;
+    if (!is_empty(waiter)) {
+        *list = waiter->next;
+        task_unpark(waiter->co);
+    }
+}
+
+static void pool_take(worker_pool_t *pool, pool_job_t *job) {
+    *job = pool->jobs[pool->head];
+    pool->head = (pool->head + 1) % pool->capacity;
+    pool->pending--;
+    pool_wake(&pool->blocked);
+}
+
+static void udp_serve(udp_packet_t *client, packet_cb handlerFunc);
+/* Serves `job` from a long lived coroutine, under a scope of its own released once
+the handler returns, the coroutine's parking state is reset, not released. */
+static void client_serve(pool_job_t *job) {
+    task_state_t *state = task_state();
+    state->scope = unique_init();
+    if (job->is_udp)
+        udp_serve((udp_packet_t *)job->client, (packet_cb)job->serve);
+    else
+        stream_serve((uv_stream_t *)job->client, (stream_cb)job->serve);
+
+    raii_delete(state->scope);
+    state->scope = nullptr;
+    state->expires = 0;
+    select_clear(state);
+}
+
+static void_t pool_worker(params_t args) {
+    worker_pool_t *pool = (worker_pool_t *)args[0].object;
+    pool_job_t job;
+
+    while (!pool->is_closing) {
+        if (!pool->pending) {
+            pool_wait(&pool->sleepers);
+            continue;
         }
+
+        pool_take(pool, &job);
+        client_serve(&job);
     }
 
-    if (result) {
-        return uv_coro_abort(nullptr, result, co);
+    if (!--pool->workers) {
+        RAII_FREE(pool->jobs);
+        RAII_FREE(pool);
     }
 
-    fs->context = co;
-    uv_req_set_data(requester(req), (void_t)fs);
     return 0;
 }
 
-static void_t uv_init(params_t uv_args) {
-    uv_args_t *uv = uv_args->object;
-    arrays_t args = uv->args;
-    int length, r, result = UV_EBADF;
-    uv_handle_t *stream = handler(args[0].object);
-    char name[SCRAPE_SIZE * 2] = nil;
-    uv->context = coro_active();
-    if (uv->is_request) {
-        uv_req_t *req;
-        switch (uv->req_type) {
-            case UV_WRITE:
-                if (uv->bind_type == RAII_SCHEME_TLS) {
-                    ((uv_tls_t *)stream)->uv_args = uv;
-                    result = uv_tls_write((uv_tls_t *)stream, &uv->bufs, tls_write_cb);
-                } else {
-                    req = try_calloc(1, sizeof(uv_write_t));
-                    if (result = uv_write((uv_write_t *)req, streamer(stream), &uv->bufs, 1, write_cb))
-                        RAII_FREE(req);
-                }
-                break;
-            case UV_CONNECT:
-                req = calloc_local(1, sizeof(uv_connect_t));
-                switch (uv->bind_type) {
-                    case RAII_SCHEME_PIPE:
-                        uv->handle_type = UV_NAMED_PIPE;
-                        uv_pipe_connect((uv_connect_t *)req, (uv_pipe_t *)stream, (string_t)args[1].char_ptr, connect_cb);
-                        result = 0;
-                        break;
-                    case RAII_SCHEME_TLS:
-                        req->data = &uv->ctx;
-                        result = uv_tcp_connect((uv_connect_t *)req, (uv_tcp_t *)stream, (sockaddr_t *)args[1].object, on_connect);
-                        break;
-                    default:
-                        uv->handle_type = UV_TCP;
-                        result = uv_tcp_connect((uv_connect_t *)req, (uv_tcp_t *)stream, (sockaddr_t *)args[1].object, connect_cb);
-                        break;
-                }
-                break;
-            case UV_UDP_SEND:
-                req = args[0].object;
-                result = uv_udp_send((uv_udp_send_t *)req, (uv_udp_t *)args[1].object,
-                                     &uv->bufs, 1, (sockaddr_t *)args[2].object, udp_send_cb);
-                break;
-            case UV_SHUTDOWN:
-                req = try_calloc(1, sizeof(uv_shutdown_t));
-                if (result = uv_shutdown((uv_shutdown_t *)req, streamer(stream), shutdown_cb))
-                    RAII_FREE(req);
-                break;
-            case UV_WORK:
-            case UV_GETADDRINFO:
-                req = try_calloc(1, sizeof(uv_getaddrinfo_t));
-                result = uv_getaddrinfo(uv_coro_loop(), (uv_getaddrinfo_t *)req,
-                                        getaddrinfo_cb, args[0].char_ptr, args[1].char_ptr,
-                                        (uv->n_args > 2 ? (const addrinfo_t *)args[2].object : nullptr));
-                if (result) {
-                    uv->args[0].object = req;
-                    uv_coro_closer(uv);
-                }
-                break;
-            case UV_GETNAMEINFO:
-                req = try_calloc(1, sizeof(uv_getnameinfo_t));
-                result = uv_getnameinfo(uv_coro_loop(), (uv_getnameinfo_t *)req,
-                                        getnameinfo_cb, (sockaddr_t *)args[0].object,
-                                        args[1].integer);
-                if (result) {
-                    uv->args[0].object = req;
-                    uv_coro_closer(uv);
-                }
-                break;
-            case UV_RANDOM:
-                break;
-            case UV_UNKNOWN_REQ:
-            default:
-                fprintf(stderr, "type; %d not supported.\033[0K\n", uv->req_type);
-                break;
-        }
-
-        if (uv->bind_type == RAII_SCHEME_TLS)
-            uv->ctx.uv_args = (void_t)uv;
-        else if (!result)
-            uv_req_set_data(req, (void_t)uv);
+/* Queues `client` for a pooled worker, parking while the queue is full. */
+static bool pool_submit(bool is_udp, void_t client, void_t handlerFunc) {
+    worker_pool_t *pool;
+    pool_job_t *job;
 
-    } else {
-        if (uv->bind_type != RAII_SCHEME_TLS)
-            uv_handle_set_data(stream, (void_t)uv);
+    /* reloaded after parking, a closed pool may be gone */
+    while (!is_empty(pool = uv_loop_data()->pool) && pool->pending >= pool->capacity)
+        pool_wait(&pool->blocked);
 
-        switch (uv->handle_type) {
-            case UV_FS_EVENT:
-                result = uv_fs_event_start((uv_fs_event_t *)stream, fs_event_cb, args[1].char_ptr, UV_FS_EVENT_RECURSIVE);
-                break;
-            case UV_FS_POLL:
-                result = uv_fs_poll_start((uv_fs_poll_t *)stream, fs_poll_cb, args[1].char_ptr, args[3].integer);
-                break;
-            case UV_CHECK:
-            case UV_IDLE:
-            case UV_NAMED_PIPE:
-            case UV_POLL:
-            case UV_PREPARE:
-                break;
-            case UV_CORO_LISTEN:
-                if (uv->bind_type == RAII_SCHEME_UDP)
-                    result = uv_udp_recv_start((uv_udp_t *)args[0].object, udp_alloc_cb, udp_recv_cb);
-                else
-                    result = uv_listen((uv_stream_t *)stream, args[1].integer, connection_cb);
+    if (is_empty(pool))
+        return false;
 
-                if (!result) {
-                    length = (int)sizeof(uv->dns->name);
-                    switch (uv->bind_type) {
-                        case RAII_SCHEME_PIPE:
-                            length = (int)sizeof(name);
-                            r = uv_pipe_getsockname((const uv_pipe_t *)args[0].object, name, (size_t *)&length);
-                            if (!is_equal(name, args[2].object)
-                                && (r = snprintf(name, sizeof(name), "%s", args[2].object)))
-                                r = 0;
-                            break;
-                        case RAII_SCHEME_UDP:
-                            r = uv_udp_getsockname((const uv_udp_t *)args[0].object, uv->dns->name, &length);
-                            break;
-                        default:
-                            r = uv_tcp_getsockname((const uv_tcp_t *)stream, uv->dns->name, &length);
-                            break;
-                    }
+    job = &pool->jobs[(pool->head + pool->pending) % pool->capacity];
+    job->is_udp = is_udp;
+    job->client = client;
+    job->serve = handlerFunc;
+    pool->pending++;
+    pool_wake(&pool->sleepers);
+    return true;
+}
+
+static void_t udp_client(params_t args);
+static void udp_packet_free(udp_packet_t *handle);
+/* Winds `pool` down, waking everyone parked on it, last worker out releases it. Queued
+clients get a coroutine of their own, or are closed along with the loop. */
+static void pool_close(worker_pool_t *pool, bool is_draining) {
+    pool_job_t job;
+    pool->is_closing = true;
+    while (pool->pending) {
+        pool_take(pool, &job);
+        if (is_draining)
+            launch(job.is_udp ? (func_t)udp_client : (func_t)stream_client, 2, job.client, job.serve);
+        else if (job.is_udp)
+            udp_packet_free((udp_packet_t *)job.client);
+        else if (((uv_args_t *)uv_handle_get_data(handler(job.client)))->bind_type == RAII_SCHEME_TLS)
+            tls_close_free(job.client);
+        else
+            uv_close_free(job.client);
+    }
 
-                    if (!r && uv->bind_type != RAII_SCHEME_PIPE) {
-                        if (is_str_in(args[3].char_ptr, ":")) {
-                            uv_ip6_name((const struct sockaddr_in6 *)uv->dns->name, uv->dns->ip, sizeof uv->dns->ip);
-                        } else if (is_str_in(args[3].char_ptr, ".")) {
-                            uv_ip4_name((const struct sockaddr_in *)uv->dns->name, uv->dns->ip, sizeof uv->dns->ip);
-                        }
-                    }
+    while (!is_empty(pool->sleepers))
+        pool_wake(&pool->sleepers);
 
-                    fprintf(stdout, "Listening to %s:%d for%s connections, %s.\033[0K\n",
-                            (uv->bind_type == RAII_SCHEME_PIPE ? name : uv->dns->ip),
-                            args[4].integer,
-                            (uv->bind_type == RAII_SCHEME_TLS ? " secure" : ""),
-                            http_std_date(0)
-                    );
+    while (!is_empty(pool->blocked))
+        pool_wake(&pool->blocked);
+}
 
-                    if (is_empty(uv_server_data()))
-                        interrupt_data_set(uv);
-                }
-                break;
-            case UV_STREAM:
-                if (uv->bind_type == RAII_SCHEME_TLS) {
-                    ((uv_tls_t *)stream)->uv_args = (void_t)uv;
-                    result = uv_tls_read(((uv_tls_t *)stream), tls_read_cb);
-                } else {
-                    result = uv_read_start((uv_stream_t *)stream, alloc_cb, read_cb);
-                }
-                break;
-            case UV_TIMER:
-                defer((func_t)uv_coro_closer, uv);
-                result = uv_timer_start((uv_timer_t *)args[0].object, timer_cb, args[1].ulong_long, 0);
-                break;
-            case UV_HANDLE:
-            case UV_PROCESS:
-            case UV_TCP:
-            case UV_TTY:
-            case UV_UDP:
-                length = $size(args) == 1 ? 0 : 1;
-                result = uv_udp_recv_start((uv_udp_t *)args[length].object, udp_alloc_cb, udp_recv_cb);
-                break;
-            case UV_SIGNAL:
-            case UV_FILE:
-                break;
-            case UV_UNKNOWN_HANDLE:
-            default:
-                fprintf(stderr, "type; %d not supported.\033[0K\n", uv->handle_type);
-                break;
+int uv_coro_pool(u32 workers, u32 max_pending) {
+    loop_data_t *data = uv_loop_data();
+    worker_pool_t *pool = data->pool;
+    u32 i;
+    if (!workers) {
+        if (!is_empty(pool)) {
+            data->pool = nullptr;
+            pool_close(pool, true);
         }
+
+        return 0;
     }
 
-    if (result) {
-        uv_log_error(result);
-        coro_await_canceled(uv->context, result);
+    if (!is_empty(pool))
+        return UV_EBUSY;
+
+    pool = try_calloc(1, sizeof(worker_pool_t));
+    pool->capacity = max_pending ? max_pending : workers;
+    pool->jobs = try_calloc(pool->capacity, sizeof(pool_job_t));
+    pool->workers = workers;
+    data->pool = pool;
+    for (i = 0; i < workers; i++)
+        launch((func_t)pool_worker, 1, pool);
+
+    return 0;
+}
+
+void stream_handler(stream_cb connected, uv_stream_t *client) {
+    if (!pool_submit(false, client, connected))
+        launch((func_t)stream_client, 2, client, connected);
+}
+
+/* Power of two stack class index of `size`, with its rounded up size in `bucket`.
+Sizes past the largest class are used as given, under index `STACK_CLASSES`. */
+static int stack_class(u32 size, u32 *bucket) {
+    int index = 0;
+    if (!size)
+        size = uv_coro_stack_size;
+
+    if (size > STACK_CLASS_MAX) {
+        *bucket = size;
+        return STACK_CLASSES;
     }
 
+    for (*bucket = STACK_CLASS_MIN; *bucket < size; *bucket <<= 1)
+        index++;
+
+    return index;
+}
+
+/* Stack size of coroutines launched next on this loop, returns the one it replaces. */
+static u32 stack_size_set(u32 size) {
+    loop_data_t *data = uv_loop_data();
+    u32 previous = data->stack_size ? data->stack_size : uv_coro_stack_size;
+    data->stack_size = size;
+    coro_stacksize_set(size);
+    return previous;
+}
+
+/* Serves its first client, then parks on its stack class for the next one,
+the stack is reused as is, no fresh allocation per client. */
+static void_t stack_worker(params_t args) {
+    stack_job_t *start = (stack_job_t *)args[0].object;
+    size_t index = start->index;
+    loop_data_t *data;
+    stack_slot_t slot;
+
+    slot.job = start->job;
+    RAII_FREE(start);
+    do {
+        client_serve(&slot.job);
+        data = uv_loop_data();
+        if (index >= STACK_CLASSES || data->is_stacks_closed || data->stacks_idle[index] >= STACK_IDLE_MAX)
+            break;
+
+        slot.co = coro_active();
+        slot.job.client = nullptr;
+        slot.next = data->stacks[index];
+        data->stacks[index] = &slot;
+        data->stacks_idle[index]++;
+        while (!is_empty(slot.co))
+            task_park(task_state());
+    } while (!is_empty(slot.job.client));
+
     return 0;
 }
 
-uv_file fs_open(string_t path, int flags, int mode) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_signed(uv_args->args, flags);
-    $append_signed(uv_args->args, mode);
+/* Hands `client` to a parked coroutine of `index` class, an empty `client` lets it finish. */
+static bool stacks_take(loop_data_t *data, size_t index, bool is_udp, void_t client, void_t serve) {
+    stack_slot_t *slot;
+    routine_t *co;
+    if (index >= STACK_CLASSES || is_empty(slot = data->stacks[index]))
+        return false;
 
-    return (uv_file)fs_start(uv_args, UV_FS_OPEN, 3, true).integer;
+    data->stacks[index] = slot->next;
+    data->stacks_idle[index]--;
+    slot->job.is_udp = is_udp;
+    slot->job.client = client;
+    slot->job.serve = serve;
+    co = slot->co;
+    slot->co = nullptr;
+    task_unpark(co);
+    return true;
+}
+
+static void stacks_close(loop_data_t *data) {
+    size_t i;
+    data->is_stacks_closed = true;
+    for (i = 0; i < STACK_CLASSES; i++) {
+        while (stacks_take(data, i, false, nullptr, nullptr))
+            ;
+    }
 }
 
-int fs_unlink(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+static void stack_handler(bool is_udp, void_t client, void_t serve, u32 stack_size) {
+    stack_job_t *start;
+    u32 bucket, previous;
+    size_t index = (size_t)stack_class(stack_size, &bucket);
+    if (stacks_take(uv_loop_data(), index, is_udp, client, serve))
+        return;
 
-    return fs_start(uv_args, UV_FS_UNLINK, 1, true).integer;
+    start = try_calloc(1, sizeof(stack_job_t));
+    start->job.is_udp = is_udp;
+    start->job.client = client;
+    start->job.serve = serve;
+    start->index = index;
+    previous = stack_size_set(bucket);
+    launch((func_t)stack_worker, 1, start);
+    stack_size_set(previous);
 }
 
-int fs_mkdir(string_t path, int mode) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_signed(uv_args->args, (mode ? mode : 0755));
+void stream_handler_ex(stream_cb connected, uv_stream_t *client, u32 stack_size) {
+    stack_handler(false, client, connected, stack_size);
+}
+
+static uv_args_t *stream_arguments(uv_stream_t *handle) {
+    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
+    if (is_type(uv_args, UV_CORO_ARGS) || is_tls(handle)) {
+        uv_args->args[0].object = handle;
+    } else {
+        uv_args = uv_arguments(1, true);
+        $append(uv_args->args, handle);
+        uv_handle_set_data(handler(handle), (void_t)uv_args);
+    }
 
-    return fs_start(uv_args, UV_FS_MKDIR, 2, true).integer;
+    return uv_args;
 }
 
-int fs_rmdir(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+RAII_INLINE int stream_write(uv_stream_t *handle, string_t text) {
+    return stream_write_buf(handle, text, simd_strlen(text));
+}
+
+/* Bytes the kernel accepted right away, zero when the write has to be queued,
+or error code the stream failed with. */
+static RAII_INLINE int stream_try_write(uv_stream_t *handle, const uv_buf_t bufs[], unsigned int nbufs) {
+    int r;
+    if (is_tls(handle) || (r = uv_try_write(handle, bufs, nbufs)) == UV_EAGAIN)
+        return 0;
+
+    if (r < 0)
+        uv_log_error(r);
+
+    return r;
+}
+
+static void cork_write_cb(uv_write_t *req, int status) {
+    if (status < 0)
+        uv_log_error(status);
+
+    bufpool_put(req->data);
+    RAII_FREE(req);
+}
+
+/* Hands buffered output to a single `uv_write()`, without waiting on it. */
+static int cork_flush(stream_cork_t *cork) {
+    uv_write_t *req;
+    uv_buf_t buf;
+    int sent, r;
+    if (cork->length == 0)
+        return 0;
+
+    if (uv_is_closing(handler(cork->handle))) {
+        cork->length = 0;
+        return UV_ECANCELED;
+    }
+
+    buf = uv_buf_init(cork->data, (unsigned int)cork->length);
+    cork->length = 0;
+    if ((sent = stream_try_write(cork->handle, &buf, 1)) < 0)
+        return sent;
+    else if ((size_t)sent == buf.len)
+        return 0;
+
+    /* buffer ownership moves to the write request */
+    req = try_calloc(1, sizeof(uv_write_t));
+    req->data = cork->data;
+    cork->data = nullptr;
+    cork->capacity = 0;
+    buf.base += sent;
+    buf.len -= (unsigned int)sent;
+    if (r = uv_write(req, cork->handle, &buf, 1, cork_write_cb)) {
+        uv_log_error(r);
+        bufpool_put(req->data);
+        RAII_FREE(req);
+    }
+
+    return r;
+}
+
+static void cork_prepare_cb(uv_prepare_t *handle) {
+    loop_data_t *data = (loop_data_t *)uv_handle_get_data(handler(handle));
+    stream_cork_t *cork;
+    while (cork = data->corked) {
+        data->corked = cork->next;
+        cork->next = nullptr;
+        cork->is_queued = false;
+        cork_flush(cork);
+    }
+
+    uv_prepare_stop(handle);
+}
+
+static void cork_queue(stream_cork_t *cork) {
+    loop_data_t *data = uv_loop_data();
+    if (is_empty(data->corker)) {
+        data->corker = try_calloc(1, sizeof(uv_prepare_t));
+        uv_prepare_init(uv_coro_loop(), data->corker);
+        uv_handle_set_data(handler(data->corker), (void_t)data);
+    }
+
+    if (is_empty(data->corked))
+        uv_prepare_start(data->corker, cork_prepare_cb);
+
+    cork->is_queued = true;
+    cork->next = data->corked;
+    data->corked = cork;
+}
+
+static void cork_unqueue(stream_cork_t *cork) {
+    loop_data_t *data = uv_loop_data();
+    stream_cork_t **link = &data->corked;
+    while (*link && *link != cork)
+        link = &(*link)->next;
+
+    if (*link)
+        *link = cork->next;
 
-    return fs_start(uv_args, UV_FS_RMDIR, 1, true).integer;
+    cork->next = nullptr;
+    cork->is_queued = false;
 }
 
-int fs_rename(string_t path, string_t new_path) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_string(uv_args->args, new_path);
-
-    return fs_start(uv_args, UV_FS_RENAME, 2, true).integer;
+/* Gives the buffer back to the pool, the next append takes one sized for the threshold. */
+static void cork_reset(stream_cork_t *cork) {
+    bufpool_put(cork->data);
+    cork->data = nullptr;
+    cork->capacity = 0;
 }
 
-int fs_link(string_t path, string_t new_path) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_string(uv_args->args, new_path);
+static int cork_append(stream_cork_t *cork, const uv_buf_t bufs[], unsigned int nbufs) {
+    size_t total = 0;
+    unsigned int i;
+    int r;
+    for (i = 0; i < nbufs; i++)
+        total += bufs[i].len;
 
-    return fs_start(uv_args, UV_FS_LINK, 2, true).integer;
-}
+    if (cork->length + total > cork->capacity && (r = cork_flush(cork)))
+        return r;
 
-scandir_t *fs_scandir(string_t path, int flags) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_signed(uv_args->args, flags);
+    /* a buffer taken under a smaller threshold can stay too small even once empty */
+    if (total > cork->capacity)
+        cork_reset(cork);
 
-    return (scandir_t *)fs_start(uv_args, UV_FS_SCANDIR, 2, true).object;
-}
+    if (is_empty(cork->data))
+        cork->data = bufpool_get(cork->threshold > total ? cork->threshold : total, &cork->capacity);
 
-uv_dirent_t *fs_scandir_next(scandir_t *dir) {
-    if (!dir->started) {
-        dir->started = true;
-        defer((func_t)fs_cleanup, dir->req);
+    for (i = 0; i < nbufs; i++) {
+        memcpy(cork->data + cork->length, bufs[i].base, bufs[i].len);
+        cork->length += bufs[i].len;
     }
 
-    if (UV_EOF != uv_fs_scandir_next(dir->req, dir->item))
-        return dir->item;
+    if (cork->length >= cork->threshold)
+        return cork_flush(cork);
 
-    return nullptr;
+    if (cork->is_auto && !cork->is_queued)
+        cork_queue(cork);
+
+    return 0;
 }
 
-uv_stat_t *fs_fstat(uv_file fd) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append(uv_args->args, casting(fd));
+static void cork_free(stream_cork_t *cork) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(cork->handle));
+    if (cork->is_queued)
+        cork_unqueue(cork);
 
-    return (uv_stat_t *)fs_start(uv_args, UV_FS_FSTAT, 1, false).object;
+    cork_flush(cork);
+    if (is_type(uv, UV_CORO_ARGS) && uv->cork == cork)
+        uv->cork = nullptr;
+
+    cork_reset(cork);
+    memset(cork, RAII_ERR, sizeof(uv_coro_types));
+    RAII_FREE(cork);
 }
 
-int fs_fsync(uv_file fd) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append(uv_args->args, casting(fd));
+static RAII_INLINE stream_cork_t *stream_corked(uv_stream_t *handle) {
+    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
+    if (!is_tls(handle) && is_type(uv_args, UV_CORO_ARGS)
+        && !is_empty(uv_args->cork) && uv_args->cork->is_active)
+        return uv_args->cork;
 
-    return fs_start(uv_args, UV_FS_FSYNC, 1, false).integer;
+    return nullptr;
 }
 
-int fs_fdatasync(uv_file fd) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append(uv_args->args, casting(fd));
+static int stream_cork_set(uv_stream_t *handle, bool is_auto, size_t threshold) {
+    stream_cork_t *cork;
+    if (is_empty(handle) || is_tls(handle))
+        return UV_ENOTSUP;
 
-    return fs_start(uv_args, UV_FS_FDATASYNC, 1, false).integer;
-}
+    uv_args_t *uv_args = stream_arguments(handle);
+    if (is_empty(cork = uv_args->cork)) {
+        cork = try_calloc(1, sizeof(stream_cork_t));
+        cork->handle = handle;
+        cork->type = UV_CORO_CORK;
+        uv_args->cork = cork;
+        client_defer((func_t)cork_free, cork);
+    } else if (cork->length >= threshold && cork_flush(cork)) {
+        return RAII_ERR;
+    }
 
-int fs_ftruncate(uv_file fd, int64_t offset) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append(uv_args->args, casting(fd));
-    $append_signed(uv_args->args, offset);
+    /* another threshold needs a buffer of its own size class */
+    if (threshold != cork->threshold && cork->length == 0)
+        cork_reset(cork);
 
-    return fs_start(uv_args, UV_FS_FTRUNCATE, 2, false).integer;
+    cork->threshold = threshold;
+    cork->is_auto = is_auto;
+    cork->is_active = true;
+    return 0;
 }
 
-int fs_fchmod(uv_file fd, int mode) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append(uv_args->args, casting(fd));
-    $append_signed(uv_args->args, mode);
+RAII_INLINE int stream_cork(uv_stream_t *handle) {
+    return stream_cork_set(handle, false, CORK_THRESHOLD);
+}
 
-    return fs_start(uv_args, UV_FS_FCHMOD, 2, false).integer;
+RAII_INLINE int stream_autocork(uv_stream_t *handle, size_t threshold) {
+    return stream_cork_set(handle, true, threshold ? threshold : CORK_THRESHOLD);
 }
 
-int fs_fchown(uv_file fd, uv_uid_t uid, uv_gid_t gid) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append(uv_args->args, casting(fd));
-    $append_char(uv_args->args, uid);
-    $append_char(uv_args->args, gid);
+int stream_uncork(uv_stream_t *handle) {
+    stream_cork_t *cork;
+    if (is_empty(handle) || is_empty(cork = stream_corked(handle)))
+        return 0;
 
-    return fs_start(uv_args, UV_FS_FCHOWN, 3, false).integer;
+    if (cork->is_queued)
+        cork_unqueue(cork);
+
+    cork->is_active = false;
+    return cork_flush(cork);
 }
 
-int fs_futime(uv_file fd, double atime, double mtime) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append(uv_args->args, casting(fd));
-    $append_double(uv_args->args, atime);
-    $append_double(uv_args->args, mtime);
+static void direct_write_cb(uv_write_t *req, int status) {
+    write_req_t *write = (write_req_t *)uv_req_get_data(requester(req));
+    if (write->is_abandoned) {
+        if (status < 0)
+            uv_log_error(status);
 
-    return fs_start(uv_args, UV_FS_FUTIME, 3, false).integer;
-}
+        write_release(write);
+        return;
+    }
 
-int fs_chmod(string_t path, int mode) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_signed(uv_args->args, mode);
+    write->status = status;
+    write->is_done = true;
+    task_unpark(write->context);
+}
+
+/* Deadline passed, caller returns while the queued write goes on from its copy. */
+static void write_expired(wheel_entry_t *entry) {
+    write_req_t *write = (write_req_t *)entry->data;
+    write->expiry = nullptr;
+    wheel_stop(entry);
+    write->is_timedout = true;
+    task_unpark(write->context);
+}
+
+/* Queues `bufs` on `handle`, parking the calling coroutine until written. Under a
+deadline the data is copied once queued, a write still queued when it passes returns
+`UV_ETIMEDOUT`, and goes out later in order, the stream stays usable. */
+static int stream_write_start(uv_stream_t *handle, uv_buf_t *bufs, unsigned int nbufs) {
+    task_state_t *state;
+    write_req_t *write;
+    uv_args_t *uv_args;
+    uv_buf_t staged;
+    u32 timeout;
+    int r;
+    if (!uv_coro_direct || is_tls(handle)) {
+        uv_args = stream_arguments(handle);
+        uv_args->bufs = bufs[0];
+        uv_args->vbufs = (nbufs > 1 ? bufs : nullptr);
+        uv_args->nbufs = (nbufs > 1 ? nbufs : 0);
+        r = uv_start(uv_args, UV_WRITE, 1, true).integer;
+        uv_args->vbufs = nullptr;
+        uv_args->nbufs = 0;
+        if (r == UV_ETIMEDOUT)
+            coro_err_set(coro_active(), r);
 
-    return fs_start(uv_args, UV_FS_CHMOD, 2, true).integer;
-}
+        return r;
+    }
 
-int fs_utime(string_t path, double atime, double mtime) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_double(uv_args->args, atime);
-    $append_double(uv_args->args, mtime);
+    write = try_calloc(1, sizeof(write_req_t));
+    write->context = coro_active();
+    uv_req_set_data(requester(&write->req), (void_t)write);
+    if (timeout = deadline_timeout(0)) {
+        staged = write_stage(write, bufs, nbufs);
+        bufs = &staged;
+        nbufs = 1;
+    }
 
-    return fs_start(uv_args, UV_FS_UTIME, 3, false).integer;
-}
+    if (r = uv_write(&write->req, handle, bufs, nbufs, direct_write_cb)) {
+        uv_log_error(r);
+        write_release(write);
+        return r;
+    }
 
-int fs_lutime(string_t path, double atime, double mtime) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_double(uv_args->args, atime);
-    $append_double(uv_args->args, mtime);
+    state = task_state();
+    if (timeout)
+        write->expiry = wheel_start(timeout, write_expired, write);
 
-    return fs_start(uv_args, UV_FS_LUTIME, 3, false).integer;
-}
+    while (!write->is_done && !write->is_timedout)
+        task_park(state);
 
-int fs_chown(string_t path, uv_uid_t uid, uv_gid_t gid) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_char(uv_args->args, uid);
-    $append_char(uv_args->args, gid);
+    if (!is_empty(write->expiry))
+        wheel_stop(write->expiry);
 
-    return fs_start(uv_args, UV_FS_CHOWN, 3, false).integer;
-}
+    if (!write->is_done) {
+        /* `direct_write_cb` releases it once written */
+        write->is_abandoned = true;
+        uv_log_error(UV_ETIMEDOUT);
+        coro_err_set(coro_active(), UV_ETIMEDOUT);
+        return UV_ETIMEDOUT;
+    }
 
-int fs_lchown(string_t path, uv_uid_t uid, uv_gid_t gid) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_char(uv_args->args, uid);
-    $append_char(uv_args->args, gid);
+    if ((r = write->status) < 0)
+        uv_log_error(r);
 
-    return fs_start(uv_args, UV_FS_LCHOWN, 3, false).integer;
+    write_release(write);
+    return r;
 }
 
-int fs_sendfile(uv_file out_fd, uv_file in_fd, int64_t in_offset, size_t length) {
-    uv_args_t *uv_args = uv_arguments(4, false);
-    $append(uv_args->args, casting(out_fd));
-    $append(uv_args->args, casting(in_fd));
-    $append_signed(uv_args->args, in_offset);
-    $append_unsigned(uv_args->args, length);
+int stream_write_buf(uv_stream_t *handle, const void *data, size_t len) {
+    stream_cork_t *cork;
+    uv_buf_t buf;
+    int sent, r;
+    if (is_empty(handle))
+        return RAII_ERR;
 
-    return fs_start(uv_args, UV_FS_SENDFILE, 4, false).integer;
-}
+    buf = uv_buf_init((string)data, (unsigned int)len);
+    if (!is_empty(cork = stream_corked(handle))) {
+        if (len < cork->threshold)
+            return cork_append(cork, &buf, 1);
 
-int fs_access(string_t path, int mode) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append_string(uv_args->args, path);
-    $append_signed(uv_args->args, mode);
+        /* too big to buffer, send what is corked first to keep ordering */
+        if (r = cork_flush(cork))
+            return r;
+    }
+
+    if ((sent = stream_try_write(handle, &buf, 1)) < 0)
+        return sent;
+    else if ((size_t)sent == len)
+        return 0;
 
-    return fs_start(uv_args, UV_FS_ACCESS, 2, true).integer;
+    buf = uv_buf_init((string)data + sent, (unsigned int)(len - sent));
+    return stream_write_start(handle, &buf, 1);
 }
 
-int fs_copyfile(string_t path, string_t new_path, int flags) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_string(uv_args->args, new_path);
-    $append_signed(uv_args->args, flags);
+int stream_writev(uv_stream_t *handle, uv_buf_t *bufs, size_t n) {
+    stream_cork_t *cork;
+    uv_buf_t partial;
+    size_t sent, i = 0;
+    int r;
+    if (is_empty(handle) || is_empty(bufs) || n == 0)
+        return RAII_ERR;
 
-    return fs_start(uv_args, UV_FS_COPYFILE, 3, true).integer;
-}
+    if (!is_empty(cork = stream_corked(handle))) {
+        for (sent = 0; i < n; i++)
+            sent += bufs[i].len;
 
-int fs_symlink(string_t path, string_t new_path, int flags) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append_string(uv_args->args, path);
-    $append_string(uv_args->args, new_path);
-    $append_signed(uv_args->args, flags);
+        if (sent < cork->threshold)
+            return cork_append(cork, bufs, (unsigned int)n);
 
-    return fs_start(uv_args, UV_FS_SYMLINK, 3, true).integer;
-}
+        if (r = cork_flush(cork))
+            return r;
 
-int fs_readlink(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+        i = 0;
+    }
 
-    return fs_start(uv_args, UV_FS_READLINK, 1, true).integer;
-}
+    if ((r = stream_try_write(handle, bufs, (unsigned int)n)) < 0)
+        return r;
 
-int fs_realpath(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+    sent = (size_t)r;
+    while (i < n && sent >= bufs[i].len) {
+        sent -= bufs[i].len;
+        i++;
+    }
 
-    return fs_start(uv_args, UV_FS_REALPATH, 1, true).integer;
-}
+    if (i == n)
+        return 0;
 
-uv_stat_t *fs_stat(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+    /* queue only the remainder, the caller's array is restored afterwards */
+    partial = bufs[i];
+    bufs[i].base += sent;
+    bufs[i].len -= sent;
+
+    r = stream_write_start(handle, bufs + i, (unsigned int)(n - i));
+    bufs[i] = partial;
 
-    return (uv_stat_t *)fs_start(uv_args, UV_FS_STAT, 1, true).object;
+    return r;
 }
 
-uv_stat_t *fs_lstat(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+/* Parks until everything already queued on `handle` has been written. */
+static int stream_drain(uv_stream_t *handle) {
+    stream_cork_t *cork;
+    uv_buf_t buf;
+    int r;
+    if (!is_empty(cork = stream_corked(handle)) && (r = cork_flush(cork)))
+        return r;
+
+    if (uv_stream_get_write_queue_size(handle) == 0)
+        return 0;
 
-    return (uv_stat_t *)fs_start(uv_args, UV_FS_LSTAT, 1, true).object;
+    buf = uv_buf_init("", 0);
+    return stream_write_start(handle, &buf, 1);
 }
 
-uv_statfs_t *fs_statfs(string_t path) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, path);
+#if !defined(_WIN32)
+/* Parks until `poll` of `uv_args` reports writable, `poll` watches a duplicate of the
+socket descriptor so the stream keeps its own registration with the loop. */
+static RAII_INLINE int sendfile_wait(uv_args_t *uv_args) {
+    return uv_start(uv_args, UV_POLL, 2, false).integer;
+}
 
-    return (uv_statfs_t *)fs_start(uv_args, UV_FS_STATFS, 1, true).object;
+/* One non blocking send of up to `length` bytes, returns bytes sent or error code. */
+static ssize_t sendfile_once(uv_os_fd_t fd, uv_file file, int64_t offset, size_t length) {
+#if defined(__linux__)
+    off_t position = (off_t)offset;
+    ssize_t n = sendfile(fd, file, &position, length);
+    return n < 0 ? uv_translate_sys_error(errno) : n;
+#else
+    /* no callback, runs right here, a non blocking socket keeps it from stalling the loop */
+    uv_fs_t req;
+    ssize_t n = uv_fs_sendfile(uv_coro_loop(), &req, (uv_file)fd, file, offset, length, nullptr);
+    uv_fs_req_cleanup(&req);
+    return n;
+#endif
 }
+#endif
 
-uv_file fs_mkstemp(string_t tpl) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, tpl);
+ssize_t stream_sendfile(uv_stream_t *handle, uv_file file, int64_t offset, size_t len) {
+    uv_os_fd_t fd;
+    uv_stat_t *stat;
+    int r;
+    if (is_empty(handle) || file < 0 || offset < 0)
+        return UV_EINVAL;
 
-    return (uv_file)fs_start(uv_args, UV_FS_MKSTEMP, 1, true).integer;
-}
+    if (is_tls(handle))
+        return UV_ENOTSUP;
 
-int fs_mkdtemp(string_t tpl) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append_string(uv_args->args, tpl);
+    if (r = uv_fileno(handler(handle), &fd))
+        return r;
 
-    return fs_start(uv_args, UV_FS_MKDTEMP, 1, true).integer;
-}
+    if (len == 0) {
+        if (is_empty(stat = fs_fstat(file)))
+            return coro_err_code();
 
-RAII_INLINE bool fs_exists(string_t path) {
-    return fs_access(path, F_OK) == 0;
-}
+        if ((int64_t)stat->st_size <= offset)
+            return 0;
 
-RAII_INLINE size_t fs_filesize(string_t path) {
-    uv_stat_t *stat = fs_stat(path);
-    if (!is_empty(stat))
-        return (size_t)stat->st_size;
+        len = (size_t)(stat->st_size - offset);
+    }
 
-    return 0;
-}
+    if (r = stream_drain(handle))
+        return r;
 
-string fs_read(uv_file fd, int64_t offset) {
-    uv_stat_t *stat = fs_fstat(fd);
-    uv_args_t *uv_args = uv_arguments(2, false);
-    size_t sz = (size_t)stat->st_size;
+#if !defined(_WIN32)
+    uv_args_t *uv_args = nullptr;
+    uv_poll_t *poll = nullptr;
+    size_t left = len;
+    ssize_t n;
+    int dupfd = -1;
+
+    while (left > 0) {
+        if ((n = sendfile_once(fd, file, offset + (int64_t)(len - left),
+                               (left < FS_FILE_CHUNK ? left : FS_FILE_CHUNK))) > 0) {
+            left -= (size_t)n;
+            continue;
+        } else if (n == 0) {
+            break;
+        } else if (n == UV_EINTR) {
+            continue;
+        } else if (n != UV_EAGAIN) {
+            r = (int)n;
+            break;
+        }
+
+        if (is_empty(poll)) {
+            poll = try_calloc(1, sizeof(uv_poll_t));
+            if ((dupfd = dup(fd)) < 0) {
+                r = uv_translate_sys_error(errno);
+                RAII_FREE(poll);
+                poll = nullptr;
+                break;
+            } else if (r = uv_poll_init(uv_coro_loop(), poll, dupfd)) {
+                close(dupfd);
+                RAII_FREE(poll);
+                poll = nullptr;
+                break;
+            }
 
-    uv_args->buffer = try_calloc(1, sz + 1);
-    uv_args->bufs = uv_buf_init(uv_args->buffer, (unsigned int)sz);
-    $append(uv_args->args, casting(fd));
-    $append_signed(uv_args->args, offset);
+            /* reused by every wait of this call */
+            uv_args = uv_arguments(2, true);
+            $append(uv_args->args, poll);
+            $append_signed(uv_args->args, UV_WRITABLE);
+        }
 
-    return fs_start(uv_args, UV_FS_READ, 2, false).char_ptr;
-}
+        if ((r = sendfile_wait(uv_args)) < 0)
+            break;
 
-int fs_write(uv_file fd, string_t text, int64_t offset) {
-    size_t size = simd_strlen(text);
-    uv_args_t *uv_args = uv_arguments(2, false);
+        r = 0;
+    }
 
-    uv_args->bufs = uv_buf_init((string)text, (unsigned int)size);
-    $append(uv_args->args, casting(fd));
-    $append_signed(uv_args->args, offset);
+    if (!is_empty(poll)) {
+        uv_close(handler(poll), _close_cb);
+        close(dupfd);
+    }
 
-    return fs_start(uv_args, UV_FS_WRITE, 2, false).integer;
+    return r ? r : (ssize_t)(len - left);
+#else
+    return UV_ENOTSUP;
+#endif
 }
 
-int fs_close(uv_file fd) {
-    uv_args_t *uv_args = uv_arguments(1, false);
-    $append(uv_args->args, casting(fd));
+string stream_read(uv_stream_t *handle) {
+    string data;
+    if (is_empty(handle))
+        return nullptr;
+
+    uv_args_t *uv_args = stream_arguments(handle);
+    if (!is_empty(uv_args->reader)) {
+        if (reader_wait(uv_args))
+            return nullptr;
+
+        data = client_calloc(1, uv_args->reader->length + 1);
+        reader_consume(uv_args->reader, data, uv_args->reader->length);
+        return data;
+    }
 
-    return fs_start(uv_args, UV_FS_CLOSE, 1, false).integer;
+    return uv_start(uv_args, UV_STREAM, 1, false).char_ptr;
 }
 
-string fs_readfile(string_t path) {
-    uv_file fd = fs_open(path, O_RDONLY, 0);
-    if (fd > 0) {
-        string file = fs_read(fd, -1);
-        fs_close(fd);
+static void select_alloc_cb(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    size_t capacity;
+    buf->base = bufpool_get(suggested_size, &capacity);
+    buf->len = (unsigned int)capacity - 1;
+}
 
-        return file;
+/* Stops every armed read, handles it set up arguments for are left with none again,
+no callback can reach them once stopped. */
+static void select_disarm(select_t *sel, int count) {
+    select_slot_t *slot;
+    uv_handle_t *h;
+    uv_args_t *uv;
+    int i;
+    if (!is_empty(sel->expiry)) {
+        wheel_stop(sel->expiry);
+        sel->expiry = nullptr;
     }
 
-    return nullptr;
+    for (i = 0; i < count; i++) {
+        h = handler(sel->handles[i]);
+        uv = (uv_args_t *)uv_handle_get_data(h);
+        if (!is_type(uv, UV_CORO_ARGS) || is_empty(slot = uv->select) || slot->sel != sel)
+            continue;
+
+        uv->select = nullptr;
+        if (h->type == UV_UDP)
+            uv_udp_recv_stop((uv_udp_t *)h);
+        else
+            uv_read_stop(streamer(h));
+
+        if (!is_empty(slot->owned)) {
+            uv_handle_set_data(h, nullptr);
+            uv_arguments_free(slot->owned);
+            slot->owned = nullptr;
+        }
+    }
 }
 
-int fs_writefile(string_t path, string_t text) {
-    int status = 0;
-    uv_file fd = fs_open(path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
-    if (fd > 0) {
-        if ((status = (int)simd_strlen(text)) > 0)
-            status = fs_write(fd, text, -1);
+static void select_clear(task_state_t *state) {
+    if (!is_empty(state->selected.data))
+        bufpool_put(state->selected.data);
+
+    memset(&state->selected, 0, sizeof(stream_selected_t));
+    state->selected.index = RAII_ERR;
+}
 
-        if (!fs_close(fd))
-            return status;
+/* First ready handle wins, every other read is stopped before it can deliver. */
+static void select_finish(select_t *sel, int index, ssize_t nread, string base) {
+    task_state_t *state = sel->state;
+    sel->is_done = true;
+    state->selected.index = index;
+    state->selected.nread = nread;
+    if (nread > 0) {
+        base[nread] = '\0';
+        state->selected.data = base;
+    } else if (!is_empty(base)) {
+        bufpool_put(base);
     }
 
-    return coro_err_code();
+    select_disarm(sel, sel->count);
+    task_unpark(state->context);
 }
 
-void fs_poll(string_t path, poll_cb pollfunc, int interval) {
-    uv_fs_poll_t *poll = fs_poll_create();
-    if (is_empty(poll))
-        raii_panic("Initialization failed: `fs_poll_create`");
+static void select_read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(stream));
+    if (nread == 0 || is_empty(uv->select)) {
+        if (!is_empty(buf->base))
+            bufpool_put(buf->base);
 
-    uv_args_t *uv_args = uv_arguments(4, false);
-    $append(uv_args->args, poll);
-    $append_string(uv_args->args, str_dup(path));
-    $append_func(uv_args->args, pollfunc);
-    $append_signed(uv_args->args, interval);
-    coro_launch(coro_fs_poll, 1, uv_args);
-}
+        return;
+    }
 
-void fs_watch(string_t path, event_cb watchfunc) {
-    uv_fs_event_t *event = fs_event_create();
-    if (is_empty(event))
-        raii_panic("Initialization failed: `fs_event_create`");
+    if (nread < 0 && nread != UV_EOF)
+        uv_log_error(nread);
 
-    uv_args_t *uv_args = uv_arguments(3, false);
-    $append(uv_args->args, event);
-    $append_string(uv_args->args, str_dup(path));
-    $append_func(uv_args->args, watchfunc);
-    coro_launch(coro_fs_event, 1, uv_args);
+    select_finish(uv->select->sel, uv->select->index, nread, buf->base);
 }
 
-dnsinfo_t *get_addrinfo(string_t address, string_t service, u32 numhints_pair, ...) {
-    uv_args_t *uv_args = uv_arguments(3, false);
-    ai_hints_types k;
-    int hint, i, count = 2;
-    va_list ap;
-    addrinfo_t *hints = nullptr;
-    $append_string(uv_args->args, address);
-    $append_string(uv_args->args, service);
-    if (numhints_pair > 0) {
-        hints = uv_args->dns->original;
-        va_start(ap, numhints_pair);
-        for (i = 0; i < numhints_pair; i++) {
-            k = va_arg(ap, ai_hints_types);
-            hint = va_arg(ap, int);
-            switch (k) {
-                case ai_family: hints->ai_family = hint; break;
-                case ai_socktype: hints->ai_socktype = hint; break;
-                case ai_protocol: hints->ai_protocol = hint; break;
-                case ai_flags: hints->ai_flags = hint; break;
-            }
-        }
-        va_end(ap);
-        $append(uv_args->args, hints);
-        count++;
+static void select_recv_cb(uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf,
+                           const struct sockaddr *addr, unsigned int flags) {
+    uv_args_t *uv = (uv_args_t *)uv_handle_get_data(handler(handle));
+    select_t *sel;
+    udp_packet_t *udp;
+    if ((nread == 0 && is_empty(addr)) || is_empty(uv->select)) {
+        if (!is_empty(buf->base))
+            bufpool_put(buf->base);
+
+        return;
     }
 
-    return (dnsinfo_t *)uv_start(uv_args, UV_GETADDRINFO, count, true).object;
+    sel = uv->select->sel;
+    if (nread > 0) {
+        udp = sel->state->packet;
+        memcpy((void_t)udp->addr, addr, sizeof(udp->addr));
+        udp->flags = flags;
+        udp->message = (string_t)buf->base;
+        udp->nread = nread;
+        udp->handle = handle;
+        /* arguments select set up go with the handle's disarm, replies get their own */
+        udp->args = is_empty(uv->select->owned) ? uv : nullptr;
+        udp->type = UV_CORO_UDP;
+        sel->state->selected.packet = udp;
+    } else if (nread < 0) {
+        uv_log_error(nread);
+    }
+
+    select_finish(sel, uv->select->index, nread, buf->base);
 }
 
-addrinfo_t *addrinfo_next(dnsinfo_t *dns) {
-    if (is_type(dns, UV_CORO_DNS) && !is_empty(dns->addr)) {
-        addrinfo_t *dir = dns->addr;
-        int ip = RAII_ERR;
-        *dns->original = *dns->addr;
-        if (dir->ai_canonname)
-            dns->ip_name = dir->ai_canonname;
+static void select_expired(wheel_entry_t *entry) {
+    select_t *sel = (select_t *)entry->data;
+    sel->expiry = nullptr;
+    wheel_stop(entry);
+    select_finish(sel, RAII_ERR, UV_ETIMEDOUT, nullptr);
+}
 
-        if (dir->ai_family == AF_INET) {
-            if (is_zero(ip = uv_ip4_name((const struct sockaddr_in *)dir->ai_addr, dns->ip, INET_ADDRSTRLEN)))
-                dns->ip_addr = dns->ip;
-        } else if (dir->ai_family == AF_INET6) {
-            if (is_zero(ip = uv_ip6_name((const struct sockaddr_in6 *)dir->ai_addr, dns->ip, INET6_ADDRSTRLEN)))
-                dns->ip6_addr = dns->ip;
-        }
+static int select_arm(select_t *sel, int index) {
+    uv_handle_t *h = handler(sel->handles[index]);
+    uv_args_t *uv;
+    if (is_empty(h))
+        return UV_EINVAL;
 
-        if (ip) {
-            uv_log_error(ip);
-            return nullptr;
+    if (h->type == UV_UDP) {
+        if (!is_type(uv = (uv_args_t *)uv_handle_get_data(h), UV_CORO_ARGS)) {
+            /* not scoped, the handle can outlive the selecting coroutine */
+            uv = uv_arguments(1, false);
+            $append(uv->args, h);
+            uv_handle_set_data(h, (void_t)uv);
+            sel->slots[index].owned = uv;
         }
-
-        dns->addr = dir->ai_next;
-        return  dns->addr;
+    } else if (is_tls(streamer(h))) {
+        return UV_ENOTSUP;
+    } else if (!is_empty((uv = stream_arguments(streamer(h)))->reader)) {
+        return UV_ENOTSUP;
     }
 
-    return nullptr;
+    sel->slots[index].sel = sel;
+    sel->slots[index].index = index;
+    uv->select = &sel->slots[index];
+    if (h->type == UV_UDP)
+        return uv_udp_recv_start((uv_udp_t *)h, select_alloc_cb, select_recv_cb);
+
+    return uv_read_start(streamer(h), select_alloc_cb, select_read_cb);
 }
 
-nameinfo_t *get_nameinfo(string_t addr, int port, int flags) {
-    uv_args_t *uv_args = uv_arguments(2, false);
-    void_t addr_set = uv_coro_sockaddr(addr, port, uv_args->dns->in6, uv_args->dns->in4);
+stream_selected_t *stream_select(void_t handles[], int n, u32 timeout) {
+    task_state_t *state;
+    select_t sel = nil;
+    int r = 0;
+    if (is_empty(handles) || n <= 0)
+        return nullptr;
 
-    if (!addr_set) {
-        $append(uv_args->args, addr_set);
-        $append_signed(uv_args->args, flags);
-        return (nameinfo_t *)uv_start(uv_args, UV_GETNAMEINFO, 2, true).object;
-    } else {
-        uv_arguments_free(uv_args);
+    state = task_state();
+    select_clear(state);
+    sel.handles = handles;
+    sel.slots = try_calloc(n, sizeof(select_slot_t));
+    sel.state = state;
+    while (sel.count < n && !(r = select_arm(&sel, sel.count)))
+        sel.count++;
+
+    if (r) {
+        /* the failed handle may be half armed too */
+        select_disarm(&sel, sel.count + 1);
+        RAII_FREE(sel.slots);
+        uv_log_error(r);
+        coro_err_set(coro_active(), r);
         return nullptr;
     }
-}
 
-static void_t stream_client(params_t args) {
-    uv_stream_t *client = (uv_stream_t *)args[0].object;
-    stream_cb handlerFunc = (stream_cb)args[1].func;
-    raii_type type = ((uv_args_t *)uv_handle_get_data(handler(client)))->bind_type;
-    uv_args_t *uv_args = uv_arguments(1, true);
+    if (timeout = deadline_timeout(timeout))
+        sel.expiry = wheel_start(timeout, select_expired, &sel);
 
-    $append(uv_args->args, client);
-    uv_args->bind_type = type;
-    uv_handle_set_data(handler(client), (void_t)uv_args);
-    if (type == RAII_SCHEME_TLS)
-        defer(tls_close_free, client);
-    else
-        defer(uv_close_free, client);
+    /* if this coroutine is halted while parked, its scope disarms every handle */
+    state->select = &sel;
+    while (!sel.is_done)
+        task_park(state);
 
-    handlerFunc(client);
-    yield();
+    state->select = nullptr;
+    RAII_FREE(sel.slots);
+    if (state->selected.nread < 0 && state->selected.nread != UV_EOF) {
+        coro_err_set(coro_active(), (int)state->selected.nread);
+        if (state->selected.nread == UV_ETIMEDOUT)
+            return nullptr;
+    }
 
-    return 0;
+    return &state->selected;
 }
 
-RAII_INLINE void stream_handler(stream_cb connected, uv_stream_t *client) {
-    launch((func_t)stream_client, 2, client, connected);
+string stream_read_timeout(uv_stream_t *handle, u32 ms) {
+    uint64_t expires;
+    string data;
+    if (is_empty(handle) || !ms)
+        return stream_read(handle);
+
+    expires = deadline_narrow(ms);
+    data = stream_read(handle);
+    deadline_restore(expires);
+
+    return data;
 }
 
-int stream_write(uv_stream_t *handle, string_t text) {
-    if (is_empty(handle))
-        return RAII_ERR;
+int stream_buffered(uv_stream_t *handle, size_t max_size) {
+    stream_reader_t *reader;
+    int r;
+    if (is_empty(handle) || is_tls(handle))
+        return UV_ENOTSUP;
 
-    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
-    if (is_type(uv_args, UV_CORO_ARGS) || is_tls(handle)) {
-        uv_args->args[0].object = handle;
-    } else {
-        uv_args = uv_arguments(1, true);
-        $append(uv_args->args, handle);
-        uv_handle_set_data(handler(handle), (void_t)uv_args);
-    }
+    uv_args_t *uv_args = stream_arguments(handle);
+    if (!is_empty(uv_args->reader))
+        return 0;
 
-    size_t size = simd_strlen(text);
-    uv_args->bufs = uv_buf_init((string)text, (unsigned int)size);
+    reader = try_calloc(1, sizeof(stream_reader_t));
+    reader->max_size = max_size ? max_size : Kb(1024);
+    reader->capacity = reader->max_size < Kb(64) ? reader->max_size : Kb(64);
+    reader->data = try_malloc(reader->capacity + 1);
+    reader->handle = handle;
+    reader->type = UV_CORO_READER;
+    uv_args->reader = reader;
+    if (r = uv_read_start(handle, reader_alloc_cb, reader_read_cb)) {
+        uv_log_error(r);
+        reader_free(reader);
+        return r;
+    }
 
-    return uv_start(uv_args, UV_WRITE, 1, true).integer;
+    client_defer((func_t)reader_free, reader);
+    return 0;
 }
 
-string stream_read(uv_stream_t *handle) {
-    if (is_empty(handle))
-        return nullptr;
+ssize_t stream_read_into(uv_stream_t *handle, void_t buf, size_t cap) {
+    stream_into_t *into;
+    ssize_t length;
+    if (is_empty(handle) || is_empty(buf) || cap == 0)
+        return UV_EINVAL;
 
-    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
-    if (is_type(uv_args, UV_CORO_ARGS) || is_tls(handle)) {
-        uv_args->args[0].object = handle;
-    } else {
-        uv_args = uv_arguments(1, true);
-        $append(uv_args->args, handle);
-        uv_handle_set_data(handler(handle), (void_t)uv_args);
+    uv_args_t *uv_args = stream_arguments(handle);
+    if (!is_empty(uv_args->reader)) {
+        if (length = reader_wait(uv_args))
+            return length;
+
+        return (ssize_t)reader_consume(uv_args->reader, buf, cap);
     }
 
-    return uv_start(uv_args, UV_STREAM, 1, false).char_ptr;
+    if (is_empty(into = uv_args->into)) {
+        into = try_calloc(1, sizeof(stream_into_t));
+        into->handle = handle;
+        uv_args->into = into;
+        client_defer((func_t)into_free, into);
+    } else if (into->pending_len) {
+        length = (ssize_t)(into->pending_len < cap ? into->pending_len : cap);
+        memcpy(buf, into->pending, length);
+        into->pending_len -= length;
+        if (into->pending_len)
+            memmove(into->pending, into->pending + length, into->pending_len);
+
+        return length;
+    }
+
+    into->buf = uv_buf_init((string)buf, (unsigned int)cap);
+    length = uv_start(uv_args, UV_STREAM, 1, false).integer;
+    into->buf = uv_buf_init(nullptr, 0);
+
+    return (ssize_t)length;
 }
 
 int stream_shutdown(uv_stream_t *handle) {
     if (is_empty(handle))
         return coro_err_code();
 
-    uv_args_t *uv_args = (uv_args_t *)uv_handle_get_data(handler(handle));
-    if (is_type(uv_args, UV_CORO_ARGS) || is_tls(handle)) {
-        uv_args->args[0].object = handle;
-    } else {
-        uv_args = uv_arguments(1, true);
-        $append(uv_args->args, handle);
-        uv_handle_set_data(handler(handle), (void_t)uv_args);
-    }
-
-    return uv_start(uv_args, UV_SHUTDOWN, 1, true).integer;
+    return uv_start(stream_arguments(handle), UV_SHUTDOWN, 1, true).integer;
 }
 
-uv_stream_t *stream_connect(string_t address) {
+static uv_stream_t *stream_connect_in(uv_handle_type scheme, string_t address, int port, u32 timeout);
+static uv_stream_t *stream_connect_url(string_t address, u32 timeout) {
     if (is_empty((void_t)address))
         return nullptr;
 
@@ -1454,13 +5367,26 @@ uv_stream_t *stream_connect(string_t address) {
     if (is_empty(url))
         return nullptr;
 
-    return stream_connect_ex(url->type, (string_t)url->host, url->port);
+    return stream_connect_in(url->type, (string_t)url->host, url->port, timeout);
+}
+
+RAII_INLINE uv_stream_t *stream_connect(string_t address) {
+    return stream_connect_url(address, 0);
 }
 
-uv_stream_t *stream_connect_ex(uv_handle_type scheme, string_t address, int port) {
+RAII_INLINE uv_stream_t *stream_connect_timeout(string_t address, u32 ms) {
+    return stream_connect_url(address, ms);
+}
+
+RAII_INLINE uv_stream_t *stream_connect_ex(uv_handle_type scheme, string_t address, int port) {
+    return stream_connect_in(scheme, address, port, 0);
+}
+
+static uv_stream_t *stream_connect_in(uv_handle_type scheme, string_t address, int port, u32 timeout) {
     uv_args_t *uv_args = uv_arguments(3, true);
     void_t addr_set = nullptr;
     void_t handle = nullptr;
+    uint64_t expires;
     char name[UV_MAXHOSTNAMESIZE] = CERTIFICATE;
     char crt[UV_MAXHOSTNAMESIZE];
     char key[UV_MAXHOSTNAMESIZE];
@@ -1496,7 +5422,7 @@ uv_stream_t *stream_connect_ex(uv_handle_type scheme, string_t address, int port
 
             evt_ctx_init_ex(&uv_args->ctx, crt, key);
             evt_ctx_set_nio(&uv_args->ctx, nullptr, uv_tls_writer);
-            defer((func_t)evt_ctx_free, &uv_args->ctx);
+            client_defer((func_t)evt_ctx_free, &uv_args->ctx);
             handle = tls_tcp_create(&uv_args->ctx);
             break;
         default:
@@ -1508,7 +5434,12 @@ uv_stream_t *stream_connect_ex(uv_handle_type scheme, string_t address, int port
     $append(uv_args->args, addr_set);
     $append_string(uv_args->args, address);
 
-    if (uv_start(uv_args, UV_CONNECT, 3, true).integer < 0)
+    expires = timeout ? deadline_narrow(timeout) : 0;
+    r = uv_start(uv_args, UV_CONNECT, 3, true).integer;
+    if (timeout)
+        deadline_restore(expires);
+
+    if (r < 0)
         return nullptr;
 
     return streamer(handle);
@@ -1526,10 +5457,38 @@ uv_stream_t *stream_listen(uv_stream_t *stream, int backlog) {
         uv_args = (uv_args_t *)((evt_ctx_t *)check)->data;
     }
 
+    if (uv_args->accepts->count)
+        return accept_shift(uv_args);
+
     uv_args->args[0].object = stream;
     uv_args->args[1].integer = backlog;
+    uv_args->accepts->is_accepting = true;
+    stream = (uv_stream_t *)uv_start(uv_args, UV_CORO_LISTEN, 5, false).object;
+    uv_args->accepts->is_accepting = false;
+
+    return stream;
+}
 
-    return (uv_stream_t *)uv_start(uv_args, UV_CORO_LISTEN, 5, false).object;
+uv_stream_t *stream_accepted(uv_stream_t *server) {
+    void_t check;
+    if (is_empty(server) || !is_type(check = uv_handle_get_data(handler(server)), UV_CORO_ARGS))
+        return nullptr;
+
+    return accept_shift((uv_args_t *)check);
+}
+
+int stream_accept_all(uv_stream_t *server, int backlog, stream_cb connected) {
+    uv_stream_t *client;
+    int count = 0;
+    if (is_empty(client = stream_listen(server, backlog)))
+        return coro_err_code() ? coro_err_code() : RAII_ERR;
+
+    do {
+        stream_handler(connected, client);
+        count++;
+    } while (!is_empty(client = stream_accepted(server)));
+
+    return count;
 }
 
 uv_stream_t *stream_bind(string_t address, int flags) {
@@ -1545,6 +5504,514 @@ uv_stream_t *stream_bind(string_t address, int flags) {
     return stream_bind_ex(url->type, (string_t)url->host, url->port, flags);
 }
 
+static void cluster_init(void) {
+    uv_mutex_init(&cluster_lock);
+    if (uv_key_create(&cluster_key))
+        abort();
+}
+
+static void cluster_stop_cb(uv_async_t *handle) {
+    cluster_t *node = (cluster_t *)uv_handle_get_data(handler(handle));
+    uv_args_t *uv;
+    void_t check;
+    if (is_empty(node->server))
+        return;
+
+    check = uv_handle_get_data(handler(node->server));
+    uv = is_type(check, UV_CORO_ARGS) ? (uv_args_t *)check : (uv_args_t *)((evt_ctx_t *)check)->data;
+    /* resume the parked `stream_listen()` empty handed, without halting its caller,
+    a listener busy dispatching sees `is_stopped` on its own */
+    if (!is_empty(uv->accepts) && uv->accepts->is_accepting) {
+        uv->accepts->is_accepting = false;
+        coro_await_finish(uv->context, nullptr, UV_ECANCELED, false);
+    }
+}
+
+static bool cluster_stopped(cluster_t *node) {
+    bool is_stopped;
+    uv_mutex_lock(&cluster_lock);
+    is_stopped = node->is_stopped;
+    uv_mutex_unlock(&cluster_lock);
+
+    return is_stopped;
+}
+
+static int cluster_serve(cluster_t *node) {
+    uv_async_t *stop;
+    int r = 0;
+#if UV_VERSION_HEX >= 0x013100
+    if (is_empty(node->server = stream_bind(node->address, UV_TCP_REUSEPORT)))
+        return coro_err_code() ? coro_err_code() : RAII_ERR;
+
+    stop = try_calloc(1, sizeof(uv_async_t));
+    uv_async_init(uv_coro_loop(), stop, cluster_stop_cb);
+    uv_handle_set_data(handler(stop), (void_t)node);
+    uv_mutex_lock(&cluster_lock);
+    node->stop = stop;
+    uv_mutex_unlock(&cluster_lock);
+    while (!cluster_stopped(node) && (r = stream_accept_all(node->server, SOMAXCONN, node->connected)) > 0);
+
+    uv_mutex_lock(&cluster_lock);
+    node->stop = nullptr;
+    if (node->is_stopped)
+        r = 0;
+    uv_mutex_unlock(&cluster_lock);
+    uv_close_free(stop);
+#else
+    r = UV_ENOTSUP;
+#endif
+    return r;
+}
+
+static int cluster_main(int argc, char **argv) {
+    cluster_t *node = (cluster_t *)uv_key_get(&cluster_key);
+    node->status = cluster_serve(node);
+    return node->status;
+}
+
+static void cluster_thread(void_t arg) {
+    uv_key_set(&cluster_key, arg);
+    coro_interrupt_setup((call_interrupter_t)uv_coro_run, uv_create_loop,
+                         uv_coro_shutdown, (call_timer_t)uv_coro_sleep, nullptr);
+    coro_stacksize_set(uv_coro_stack_size);
+    coro_start(cluster_main, 0, nullptr, 0);
+}
+
+int stream_bind_cluster(string_t address, int nthreads, stream_cb connected) {
+    cluster_t *nodes;
+    int i, r;
+    if (is_empty((void_t)address) || is_empty(connected))
+        return UV_EINVAL;
+
+    if (nthreads <= 0)
+        nthreads = thrd_cpu_count();
+
+    uv_once(&cluster_once, cluster_init);
+    nodes = calloc_local(nthreads, sizeof(cluster_t));
+    for (i = 0; i < nthreads; i++) {
+        nodes[i].address = address;
+        nodes[i].connected = connected;
+    }
+
+    uv_mutex_lock(&cluster_lock);
+    if (!is_empty(uv_coro_cluster)) {
+        uv_mutex_unlock(&cluster_lock);
+        return UV_EBUSY;
+    }
+
+    uv_coro_cluster = nodes;
+    uv_coro_cluster_count = nthreads;
+    uv_mutex_unlock(&cluster_lock);
+    for (i = 1; i < nthreads; i++) {
+        if (r = uv_thread_create(&nodes[i].thread, cluster_thread, &nodes[i])) {
+            uv_log_error(r);
+            nthreads = i;
+            break;
+        }
+    }
+
+    r = cluster_serve(&nodes[0]);
+    for (i = 1; i < nthreads; i++) {
+        uv_thread_join(&nodes[i].thread);
+        if (!r && nodes[i].status < 0)
+            r = nodes[i].status;
+    }
+
+    uv_mutex_lock(&cluster_lock);
+    uv_coro_cluster = nullptr;
+    uv_coro_cluster_count = 0;
+    uv_mutex_unlock(&cluster_lock);
+
+    return r;
+}
+
+int stream_cluster_stop(void) {
+    int i;
+    uv_once(&cluster_once, cluster_init);
+    uv_mutex_lock(&cluster_lock);
+    if (is_empty(uv_coro_cluster)) {
+        uv_mutex_unlock(&cluster_lock);
+        return UV_EINVAL;
+    }
+
+    for (i = 0; i < uv_coro_cluster_count; i++) {
+        uv_coro_cluster[i].is_stopped = true;
+        /* a listener still binding has no wakeup handle yet, it sees `is_stopped` itself */
+        if (!is_empty(uv_coro_cluster[i].stop))
+            uv_async_send(uv_coro_cluster[i].stop);
+    }
+    uv_mutex_unlock(&cluster_lock);
+
+    return 0;
+}
+
+static void task_queue_init(task_queue_t *queue) {
+    uv_mutex_init(&queue->lock);
+    queue->capacity = 64;
+    queue->jobs = try_calloc(queue->capacity, sizeof(task_job_t *));
+}
+
+static void task_queue_free(task_queue_t *queue) {
+    while (queue->head < queue->tail)
+        RAII_FREE(queue->jobs[queue->head++ % queue->capacity]);
+
+    RAII_FREE(queue->jobs);
+    uv_mutex_destroy(&queue->lock);
+}
+
+static void task_enqueue(task_queue_t *queue, task_job_t *job) {
+    task_job_t **jobs;
+    size_t i, count;
+    uv_mutex_lock(&queue->lock);
+    count = queue->tail - queue->head;
+    if (count == queue->capacity) {
+        jobs = try_calloc(queue->capacity * 2, sizeof(task_job_t *));
+        for (i = 0; i < count; i++)
+            jobs[i] = queue->jobs[(queue->head + i) % queue->capacity];
+
+        RAII_FREE(queue->jobs);
+        queue->jobs = jobs;
+        queue->head = 0;
+        queue->tail = count;
+        queue->capacity *= 2;
+    }
+
+    queue->jobs[queue->tail++ % queue->capacity] = job;
+    uv_mutex_unlock(&queue->lock);
+}
+
+static task_job_t *task_dequeue(task_queue_t *queue) {
+    task_job_t *job = nullptr;
+    uv_mutex_lock(&queue->lock);
+    if (queue->head < queue->tail)
+        job = queue->jobs[queue->head++ % queue->capacity];
+    uv_mutex_unlock(&queue->lock);
+
+    return job;
+}
+
+static task_ring_t *task_ring(int64_t capacity, task_ring_t *retired) {
+    task_ring_t *ring = try_calloc(1, sizeof(task_ring_t) + (size_t)(capacity - 1) * sizeof(task_job_t *));
+    ring->capacity = capacity;
+    ring->retired = retired;
+    return ring;
+}
+
+static void task_deque_init(task_deque_t *deque) {
+    deque->ring = task_ring(64, nullptr);
+}
+
+/* Only once every thread using `deque` is gone. */
+static void task_deque_free(task_deque_t *deque) {
+    task_ring_t *ring = deque->ring, *retired;
+    while (deque->top < deque->bottom)
+        RAII_FREE(ring->jobs[deque->top++ % ring->capacity]);
+
+    for (; !is_empty(ring); ring = retired) {
+        retired = ring->retired;
+        RAII_FREE(ring);
+    }
+}
+
+/* Owner only. */
+static void task_push(task_deque_t *deque, task_job_t *job) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE), i;
+    task_ring_t *ring = __atomic_load_n(&deque->ring, __ATOMIC_RELAXED), *grown;
+
+    if (bottom - top > ring->capacity - 1) {
+        grown = task_ring(ring->capacity * 2, ring);
+        for (i = top; i < bottom; i++)
+            grown->jobs[i % grown->capacity] = __atomic_load_n(&ring->jobs[i % ring->capacity], __ATOMIC_RELAXED);
+
+        __atomic_store_n(&deque->ring, grown, __ATOMIC_RELEASE);
+        ring = grown;
+    }
+
+    __atomic_store_n(&ring->jobs[bottom % ring->capacity], job, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+}
+
+/* Owner only, newest first. */
+static task_job_t *task_pop(task_deque_t *deque) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1, top;
+    task_ring_t *ring = __atomic_load_n(&deque->ring, __ATOMIC_RELAXED);
+    task_job_t *job = nullptr;
+
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+    if (top <= bottom) {
+        job = __atomic_load_n(&ring->jobs[bottom % ring->capacity], __ATOMIC_RELAXED);
+        if (top != bottom)
+            return job;
+
+        /* last one, thieves may be after it too */
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            job = nullptr;
+    }
+
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return job;
+}
+
+/* Any thread, oldest first, retrying when another thread wins the same task. */
+static task_job_t *task_steal(task_deque_t *deque) {
+    int64_t top, bottom;
+    task_ring_t *ring;
+    task_job_t *job;
+
+    while (true) {
+        top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+        if (top >= bottom)
+            return nullptr;
+
+        ring = __atomic_load_n(&deque->ring, __ATOMIC_ACQUIRE);
+        job = __atomic_load_n(&ring->jobs[top % ring->capacity], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            return job;
+    }
+}
+
+/* Own queue newest first, then the shared queue, then oldest task of another worker. */
+static task_job_t *task_take(task_worker_t *worker) {
+    task_runtime_t *rt = worker->runtime;
+    task_job_t *job;
+    int i;
+    if (job = task_pop(&worker->deque))
+        return job;
+
+    if (job = task_dequeue(&rt->injector))
+        return job;
+
+    for (i = 1; i < rt->count; i++) {
+        if (job = task_steal(&rt->workers[(worker->id + i) % rt->count].deque))
+            return job;
+    }
+
+    return nullptr;
+}
+
+/* Wakes one parked worker, or all of them when stopping. */
+static void task_notify(task_runtime_t *rt, bool is_all) {
+    int i;
+    uv_mutex_lock(&rt->lock);
+    for (i = 0; i < rt->count; i++) {
+        if (rt->workers[i].is_parked && !is_empty(rt->workers[i].wakeup)) {
+            rt->workers[i].is_parked = false;
+            uv_async_send(rt->workers[i].wakeup);
+            if (!is_all)
+                break;
+        }
+    }
+    uv_mutex_unlock(&rt->lock);
+}
+
+static void task_wakeup_cb(uv_async_t *handle) {
+    task_worker_t *worker = (task_worker_t *)uv_handle_get_data(handler(handle));
+    worker->is_woken = true;
+    task_unpark(worker->context);
+}
+
+static void_t task_run(params_t args) {
+    task_job_t *job = (task_job_t *)args[0].object;
+    task_worker_t *worker = (task_worker_t *)uv_key_get(&task_key);
+    task_runtime_t *rt = worker->runtime;
+    arrays_t params = arrays();
+    size_t i;
+    bool is_done;
+
+    for (i = 0; i < job->n_args; i++)
+        $append(params, job->argv[i].object);
+
+    job->fn(params);
+    RAII_FREE(job);
+    worker->running--;
+
+    uv_mutex_lock(&rt->lock);
+    is_done = !--rt->pending && rt->is_stopping;
+    uv_mutex_unlock(&rt->lock);
+    if (is_done)
+        task_notify(rt, true);
+
+    return 0;
+}
+
+static int task_main(int argc, char **argv) {
+    task_worker_t *worker = (task_worker_t *)argv;
+    task_runtime_t *rt = worker->runtime;
+    task_job_t *job;
+    uv_async_t *wakeup = try_calloc(1, sizeof(uv_async_t));
+
+    uv_async_init(uv_coro_loop(), wakeup, task_wakeup_cb);
+    uv_handle_set_data(handler(wakeup), (void_t)worker);
+    uv_mutex_lock(&rt->lock);
+    worker->wakeup = wakeup;
+    uv_mutex_unlock(&rt->lock);
+    while (true) {
+        if (job = task_take(worker)) {
+            worker->running++;
+            launch((func_t)task_run, 1, job);
+            yield();
+            continue;
+        }
+
+        uv_mutex_lock(&rt->lock);
+        if (rt->is_stopping && !rt->pending) {
+            uv_mutex_unlock(&rt->lock);
+            break;
+        }
+
+        worker->is_parked = true;
+        uv_mutex_unlock(&rt->lock);
+
+        /* a task pushed before parking got flagged is picked up here */
+        if (job = task_take(worker)) {
+            uv_mutex_lock(&rt->lock);
+            worker->is_parked = false;
+            uv_mutex_unlock(&rt->lock);
+            worker->running++;
+            launch((func_t)task_run, 1, job);
+            yield();
+            continue;
+        }
+
+        /* parked, the scheduler waits in the loop through `uv_coro_run()`, which
+        blocks there while no task of this worker is running */
+        while (!worker->is_woken) {
+            worker->context = coro_active();
+            task_park(task_state());
+            worker->context = nullptr;
+        }
+
+        worker->is_woken = false;
+    }
+
+    uv_mutex_lock(&rt->lock);
+    worker->is_parked = false;
+    uv_close(handler(worker->wakeup), _close_cb);
+    worker->wakeup = nullptr;
+    uv_mutex_unlock(&rt->lock);
+
+    return 0;
+}
+
+static void task_key_init(void) {
+    if (uv_key_create(&task_key))
+        abort();
+}
+
+static void task_thread(void_t arg) {
+    uv_key_set(&task_key, arg);
+    coro_interrupt_setup((call_interrupter_t)uv_coro_run, uv_create_loop,
+                         uv_coro_shutdown, (call_timer_t)uv_coro_sleep, nullptr);
+    coro_stacksize_set(uv_coro_stack_size);
+    coro_start(task_main, 0, (char **)arg, 0);
+}
+
+int uv_coro_workers(int nthreads) {
+    task_runtime_t *rt;
+    int i, r;
+    if (!is_empty(uv_coro_runtime))
+        return UV_EBUSY;
+
+    if (nthreads <= 0)
+        nthreads = thrd_cpu_count();
+
+    uv_once(&task_once, task_key_init);
+
+    rt = try_calloc(1, sizeof(task_runtime_t));
+    rt->workers = try_calloc(nthreads, sizeof(task_worker_t));
+    uv_mutex_init(&rt->lock);
+    task_queue_init(&rt->injector);
+    for (i = 0; i < nthreads; i++) {
+        rt->workers[i].id = i;
+        rt->workers[i].runtime = rt;
+        task_deque_init(&rt->workers[i].deque);
+    }
+
+    rt->count = nthreads;
+    uv_coro_runtime = rt;
+    for (i = 0; i < nthreads; i++) {
+        if (r = uv_thread_create(&rt->workers[i].thread, task_thread, &rt->workers[i])) {
+            uv_log_error(r);
+            rt->count = i;
+            break;
+        }
+    }
+
+    return rt->count ? 0 : r;
+}
+
+int uv_coro_task(callable_t fn, size_t n_args, ...) {
+    task_runtime_t *rt = uv_coro_runtime;
+    task_worker_t *worker;
+    task_job_t *job;
+    va_list ap;
+    size_t i;
+    if (is_empty(rt) || !rt->count)
+        return UV_ENOTSUP;
+
+    if (is_empty(fn))
+        return UV_EINVAL;
+
+    job = try_calloc(1, sizeof(task_job_t) + n_args * sizeof(value_t));
+    job->fn = fn;
+    job->n_args = n_args;
+    va_start(ap, n_args);
+    for (i = 0; i < n_args; i++)
+        job->argv[i].object = va_arg(ap, void_t);
+    va_end(ap);
+
+    uv_mutex_lock(&rt->lock);
+    if (rt->is_stopping) {
+        uv_mutex_unlock(&rt->lock);
+        RAII_FREE(job);
+        return UV_ECANCELED;
+    }
+
+    rt->pending++;
+    uv_mutex_unlock(&rt->lock);
+
+    worker = (task_worker_t *)uv_key_get(&task_key);
+    if (is_empty(worker))
+        task_enqueue(&rt->injector, job);
+    else
+        task_push(&worker->deque, job);
+
+    task_notify(rt, false);
+
+    return 0;
+}
+
+int uv_coro_workers_stop(void) {
+    task_runtime_t *rt = uv_coro_runtime;
+    int i;
+    if (is_empty(rt))
+        return UV_EINVAL;
+
+    uv_mutex_lock(&rt->lock);
+    rt->is_stopping = true;
+    uv_mutex_unlock(&rt->lock);
+    task_notify(rt, true);
+    for (i = 0; i < rt->count; i++) {
+        /* a worker still starting up has no wakeup handle yet, it sees `is_stopping` itself */
+        uv_thread_join(&rt->workers[i].thread);
+        task_deque_free(&rt->workers[i].deque);
+    }
+
+    uv_coro_runtime = nullptr;
+    task_queue_free(&rt->injector);
+    uv_mutex_destroy(&rt->lock);
+    RAII_FREE(rt->workers);
+    RAII_FREE(rt);
+
+    return 0;
+}
+
 uv_stream_t *stream_bind_ex(uv_handle_type scheme, string_t address, int port, int flags) {
     void_t addr_set = nullptr, handle;
     int r = 0;
@@ -1568,7 +6035,7 @@ uv_stream_t *stream_bind_ex(uv_handle_type scheme, string_t address, int port, i
             handle = pipe_create(false);
             r = uv_pipe_bind(handle, (string_t)addr_set);
             if (!r)
-                defer((func_t)fs_remove_pipe, uv_args);
+                client_defer((func_t)fs_remove_pipe, uv_args);
             break;
         case RAII_SCHEME_TLS:
             if (is_str_eq(name, "localhost"))
@@ -1582,7 +6049,7 @@ uv_stream_t *stream_bind_ex(uv_handle_type scheme, string_t address, int port, i
 
             evt_ctx_init_ex(&uv_args->ctx, crt, key);
             evt_ctx_set_nio(&uv_args->ctx, nullptr, uv_tls_writer);
-            defer((func_t)evt_ctx_free, &uv_args->ctx);
+            client_defer((func_t)evt_ctx_free, &uv_args->ctx);
             handle = tls_tcp_create(&uv_args->ctx);
             r = uv_tcp_bind(handle, (sockaddr_t *)addr_set, flags);
             break;
@@ -1603,11 +6070,15 @@ uv_stream_t *stream_bind_ex(uv_handle_type scheme, string_t address, int port, i
     $append_signed(uv_args->args, port);
 
     uv_args->bind_type = scheme;
+    uv_args->accepts = try_calloc(1, sizeof(accept_queue_t));
     if (scheme == RAII_SCHEME_TLS)
         uv_args->ctx.data = (void_t)uv_args;
     else
         uv_handle_set_data(handler(handle), (void_t)uv_args);
 
+    /* runs ahead of the listener's own close, deferred earlier */
+    client_defer((func_t)accept_release, uv_args);
+
     return streamer(handle);
 }
 
@@ -1685,7 +6156,7 @@ udp_packet_t *udp_listen(uv_udp_t *handle) {
 
 static void udp_packet_free(udp_packet_t *handle) {
     if (is_udp_packet(handle)) {
-        RAII_FREE((void_t)handle->message);
+        bufpool_put((void_t)handle->message);
         memset((void_t)handle, RAII_ERR, sizeof(uv_coro_types));
         RAII_FREE((void_t)handle);
     }
@@ -1699,21 +6170,27 @@ RAII_INLINE unsigned int udp_get_flags(udp_packet_t *udpp) {
     return udpp->flags;
 }
 
-static void_t udp_client(params_t args) {
-    udp_packet_t *client = (udp_packet_t *)args[0].object;
-    packet_cb handlerFunc = (packet_cb)args[1].func;
-
+static void udp_serve(udp_packet_t *client, packet_cb handlerFunc) {
     if (is_empty(client->args))
-        defer((func_t)udp_packet_free, client);
+        client_defer((func_t)udp_packet_free, client);
 
     handlerFunc(client);
+}
 
+static void_t udp_client(params_t args) {
+    udp_serve((udp_packet_t *)args[0].object, (packet_cb)args[1].func);
     return 0;
 }
 
-RAII_INLINE void udp_handler(packet_cb connected, udp_packet_t *client) {
+void udp_handler(packet_cb connected, udp_packet_t *client) {
+    yield();
+    if (!pool_submit(true, client, connected))
+        launch((func_t)udp_client, 2, client, connected);
+}
+
+void udp_handler_ex(packet_cb connected, udp_packet_t *client, u32 stack_size) {
     yield();
-    launch((func_t)udp_client, 2, client, connected);
+    stack_handler(true, client, connected, stack_size);
 }
 
 int udp_send(uv_udp_t *handle, string_t message, string_t addr) {
@@ -1746,7 +6223,7 @@ int udp_send(uv_udp_t *handle, string_t message, string_t addr) {
         size_t size = simd_strlen(message);
         uv_args->bufs = uv_buf_init((string)message, (unsigned int)size);
         if (is_args_set) {
-            packet = calloc_local(1, sizeof(udp_packet_t));
+            packet = client_calloc(1, sizeof(udp_packet_t));
             $append(uv_args->args, packet->req);
             $append(uv_args->args, handle);
             $append(uv_args->args, addr_set);
@@ -1779,8 +6256,9 @@ RAII_INLINE int udp_send_packet(udp_packet_t *connected, string_t message) {
         return RAII_ERR;
 
     size_t size = simd_strlen(message);
-    uv_args_t *uv_args = nullptr;
-    if (is_type(connected->args, UV_CORO_ARGS)) {
+    uv_args_t *uv_args = (uv_args_t *)connected->args;
+    /* reused for every reply on this packet, a received one carries its receiver's */
+    if (is_type(uv_args, UV_CORO_ARGS) && $size(uv_args->args) == 4) {
         uv_args->args[0].object = connected->req;
         uv_args->args[1].object = connected->handle;
         uv_args->args[2].object = (void_t)connected->addr;
@@ -1820,16 +6298,6 @@ static uv_fs_poll_t *fs_poll_create(void) {
     return poll;
 }
 
-static uv_timer_t *time_create(void) {
-    uv_timer_t *timer = (uv_timer_t *)try_calloc(1, sizeof(uv_timer_t));
-    int r = uv_timer_init(uv_coro_loop(), timer);
-    if (r) {
-        return uv_coro_abort(timer, r, coro_active());
-    }
-
-    return timer;
-}
-
 uv_udp_t *udp_create(void) {
     uv_udp_t *udp = (uv_udp_t *)try_calloc(1, sizeof(uv_udp_t));
     int r = uv_udp_init(uv_coro_loop(), udp);
@@ -1837,7 +6305,7 @@ uv_udp_t *udp_create(void) {
         return uv_coro_abort(udp, r, coro_active());
     }
 
-    defer(uv_close_deferred, udp);
+    client_defer((func_t)uv_close_deferred, udp);
     return udp;
 }
 
@@ -1849,7 +6317,7 @@ uv_pipe_t *pipe_create_ex(bool is_ipc, bool autofree) {
     }
 
     if (autofree)
-        defer(uv_close_deferred, pipe);
+        client_defer((func_t)uv_close_deferred, pipe);
 
     return pipe;
 }
@@ -1866,7 +6334,7 @@ pipe_file_t *pipe_file(uv_file fd, bool is_ipc) {
         return uv_coro_abort(pipe, r, coro_active());
     }
 
-    defer(uv_close_deferred, pipe);
+    client_defer((func_t)uv_close_deferred, pipe);
     pipe->type = UV_CORO_PIPE_FD;
     return pipe;
 }
@@ -1879,7 +6347,7 @@ pipe_in_t *pipe_stdin(bool is_ipc) {
         return uv_coro_abort(pipe, r, coro_active());
     }
 
-    defer(uv_close_deferred, pipe);
+    client_defer((func_t)uv_close_deferred, pipe);
     pipe->type = UV_CORO_PIPE_0;
     return pipe;
 }
@@ -1892,7 +6360,7 @@ pipe_out_t *pipe_stdout(bool is_ipc) {
         return uv_coro_abort(pipe, r, coro_active());
     }
 
-    defer(uv_close_deferred, pipe);
+    client_defer((func_t)uv_close_deferred, pipe);
     pipe->type = UV_CORO_PIPE_1;
     return pipe;
 }
@@ -1921,7 +6389,7 @@ pipepair_t *pipepair_create(bool is_ipc) {
     $append(uv_args2->args, pair->writer);
     uv_handle_set_data(handler(pair->reader), (void_t)uv_args);
     uv_handle_set_data(handler(pair->writer), (void_t)uv_args2);
-    defer(uv_close_deferred, pair);
+    client_defer((func_t)uv_close_deferred, pair);
     pair->type = UV_CORO_PIPE;
     return pair;
 }
@@ -1944,7 +6412,7 @@ socketpair_t *socketpair_create(int type, int protocol) {
         return uv_coro_abort(pair, r, co);
     }
 
-    defer(uv_close_deferred, pair);
+    client_defer((func_t)uv_close_deferred, pair);
     pair->type = UV_CORO_SOCKET;
     return pair;
 }
@@ -1956,7 +6424,7 @@ uv_tcp_t *tcp_create(void) {
         return uv_coro_abort(tcp, r, coro_active());
     }
 
-    defer(uv_close_deferred, tcp);
+    client_defer((func_t)uv_close_deferred, tcp);
     return tcp;
 }
 
@@ -1971,7 +6439,7 @@ tty_in_t *tty_in(void) {
     uv_args_t *uv_args = uv_arguments(1, true);
     $append(uv_args->args, tty->reader);
     uv_handle_set_data(handler(tty->reader), (void_t)uv_args);
-    defer(uv_close_deferred, tty);
+    client_defer((func_t)uv_close_deferred, tty);
     tty->type = UV_CORO_TTY_0;
     return tty;
 }
@@ -1987,7 +6455,7 @@ tty_out_t *tty_out(void) {
     uv_args_t *uv_args = uv_arguments(1, true);
     $append(uv_args->args, tty->writer);
     uv_handle_set_data(handler(tty->writer), (void_t)uv_args);
-    defer(uv_close_deferred, tty);
+    client_defer((func_t)uv_close_deferred, tty);
     tty->type = UV_CORO_TTY_1;
     return tty;
 }
@@ -2003,13 +6471,13 @@ tty_err_t *tty_err(void) {
     uv_args_t *uv_args = uv_arguments(1, true);
     $append(uv_args->args, tty->erred);
     uv_handle_set_data(handler(tty->erred), (void_t)uv_args);
-    defer(uv_close_deferred, tty);
+    client_defer((func_t)uv_close_deferred, tty);
     tty->type = UV_CORO_TTY_2;
     return tty;
 }
 
 static uv_tcp_t *tls_tcp_create(void_t extra) {
-    uv_tcp_t *tcp = (uv_tcp_t *)calloc_full(coro_scope(), 1, sizeof(uv_tcp_t), tls_close_free);
+    uv_tcp_t *tcp = (uv_tcp_t *)calloc_full(client_scope(), 1, sizeof(uv_tcp_t), tls_close_free);
     tcp->data = extra;
     int r = uv_tcp_init(uv_coro_loop(), tcp);
     if (r) {
@@ -2441,12 +6909,14 @@ static void uv_coro_shutdown(void_t t) {
         }
 
         if (loop) {
+            uv_loop_data_close(loop);
             if (uv_loop_alive(loop)) {
                 uv_walk(loop, (uv_walk_cb)uv_close_free, nullptr);
                 uv_run(loop, UV_RUN_DEFAULT);
             }
 
             uv_loop_close(loop);
+            uv_loop_data_free(loop);
             RAII_FREE((void_t)loop);
             interrupt_handle_set(nullptr);
         }
@@ -2464,23 +6934,35 @@ static void uv_create_loop(void) {
     interrupt_handle_set(handle);
 }
 
-static u32 uv_coro_sleep(u32 ms) {
-    uv_timer_t *timer = time_create();
-    if (is_empty(timer))
-        return RAII_ERR;
+static void sleep_fired(wheel_entry_t *entry) {
+    routine_t *co = (routine_t *)entry->data;
+    coro_halt_set(get_coro_context(get_coro_context(co)));
+    coro_await_finish(co, nullptr, 0, false);
+}
 
-    uv_args_t *uv_args = uv_arguments(2, false);
-    $append(uv_args->args, timer);
-    $append_unsigned(uv_args->args, ms);
-    coro_timer_set(coro_active(), (void_t)timer);
-    return uv_start(uv_args, UV_TIMER, 2, false).u_int;
+/* Sleeps ride the loop's timer wheel, there is no `uv_timer_t` of their own to
+hand `coro_timer_set()`, the entry is cancelled by the deferred `wheel_stop()`. */
+static void_t sleep_init(params_t args) {
+    wheel_entry_t *entry = wheel_start(args[0].u_int, sleep_fired, coro_active());
+    defer((func_t)wheel_stop, entry);
+    return 0;
+}
+
+static u32 uv_coro_sleep(u32 ms) {
+    return coro_await(sleep_init, 1, ms).u_int;
 }
 
 main(int argc, char **argv) {
+    int r;
     uv_replace_allocator(rp_malloc, rp_realloc, rp_calloc, rpfree);
     RAII_INFO("%s, %s\n\n", uv_coro_uname(), uv_coro_hostname());
-    coro_interrupt_setup((call_interrupter_t)uv_run, uv_create_loop,
+    coro_interrupt_setup((call_interrupter_t)uv_coro_run, uv_create_loop,
                          uv_coro_shutdown, (call_timer_t)uv_coro_sleep, nullptr);
-    coro_stacksize_set(Kb(64));
-    return coro_start((coro_sys_func)uv_main, argc, argv, 0);
+    coro_stacksize_set(uv_coro_stack_size);
+    r = coro_start((coro_sys_func)uv_main, argc, argv, 0);
+    /* workers started from `uv_main()` finish their tasks before the process does */
+    if (!is_empty(uv_coro_runtime))
+        uv_coro_workers_stop();
+
+    return r;
 }
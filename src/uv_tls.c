@@ -411,9 +411,10 @@ int evt_is_tls_stream(const char *bfr, const int nrd) {
 
 static void alloc_cb(uv_handle_t *handle, size_t size, uv_buf_t *buf)
 {
-    buf->base = (char*)malloc(size);
-    memset(buf->base, 0, size);
-    buf->len = (unsigned long)size;
+    size_t capacity;
+    //pooled per loop, evt_tls_feed_data only consumes `nrd` bytes so no zeroing
+    buf->base = bufpool_get(size, &capacity);
+    buf->len = (unsigned long)capacity;
     RAII_ASSERT(buf->base != NULL && "Memory allocation failed");
 }
 
@@ -479,11 +480,11 @@ void on_tcp_read(uv_stream_t *stream, ssize_t nrd, const uv_buf_t *data)
                 uv_close((uv_handle_t*)stream, on_tcp_eof);
             }
         }
-        free(data->base);
+        bufpool_put(data->base);
         return;
     }
     evt_tls_feed_data(parent->tls, data->base, (int)nrd);
-    free(data->base);
+    bufpool_put(data->base);
 }
 
 static void on_hd_complete( evt_tls_t *t, int status)
@@ -584,3 +585,82 @@ int uv_tls_write(uv_tls_t *stream, uv_buf_t *buf, uv_tls_write_cb cb)
 
     return evt_tls_write(evt, buf->base, buf->len, on_evt_write);
 }
+
+//SSL_write all of `data`, flushing the BIO pair to network whenever it fills up,
+//returns bytes written or -1
+static int tls_write_all(evt_tls_t *evt, const char *data, int len)
+{
+    int r = 0, offset;
+    for (offset = 0; offset < len; offset += r) {
+        r = SSL_write(evt->ssl, data + offset, len - offset);
+        if (r <= 0) {
+            if (SSL_get_error(evt->ssl, r) == SSL_ERROR_WANT_WRITE
+                && evt__send_pending(evt) > 0) {
+                r = 0;
+                continue;
+            }
+
+            return -1;
+        }
+    }
+
+    return len;
+}
+
+int uv_tls_writev(uv_tls_t *stream, uv_buf_t bufs[], unsigned int nbufs, uv_tls_write_cb cb)
+{
+    unsigned int i;
+    int offset, length, total = 0, staged = 0;
+    char *record = NULL;
+    RAII_ASSERT( stream != NULL);
+    stream->tls_wr_cb = cb;
+    evt_tls_t *evt = stream->tls;
+    RAII_ASSERT( evt != NULL);
+    evt->write_cb = on_evt_write;
+
+    //every SSL_write closes a record, so small buffers are gathered into one
+    //record sized chunk first, buffers that fill a record go out as they are
+    for (i = 0; i < nbufs; i++) {
+        for (offset = 0; offset < (int)bufs[i].len; offset += length) {
+            length = (int)bufs[i].len - offset;
+            if (!staged && length >= SSL3_RT_MAX_PLAIN_LENGTH) {
+                if (tls_write_all(evt, bufs[i].base + offset, length) < 0)
+                    goto fail;
+
+                total += length;
+                continue;
+            }
+
+            if (record == NULL && (record = malloc(SSL3_RT_MAX_PLAIN_LENGTH)) == NULL)
+                return UV_ENOMEM;
+
+            if (length > SSL3_RT_MAX_PLAIN_LENGTH - staged)
+                length = SSL3_RT_MAX_PLAIN_LENGTH - staged;
+
+            memcpy(record + staged, bufs[i].base + offset, length);
+            if ((staged += length) == SSL3_RT_MAX_PLAIN_LENGTH) {
+                if (tls_write_all(evt, record, staged) < 0)
+                    goto fail;
+
+                total += staged;
+                staged = 0;
+            }
+        }
+    }
+
+    if (staged) {
+        if (tls_write_all(evt, record, staged) < 0)
+            goto fail;
+
+        total += staged;
+    }
+
+    free(record);
+    evt__send_pending(evt);
+    on_evt_write(evt, total);
+    return 0;
+
+fail:
+    free(record);
+    return UV_EPROTO;
+}
@@ -66,6 +66,43 @@ void_t worker_misc(params_t args) {
     return args[1].char_ptr;
 }
 
+TEST(fs_readv_writev) {
+    char head[4] = nil, body[6] = nil, tail[2] = nil;
+    uv_buf_t out[3], in[3];
+    uv_file fd = fs_open("vector.file", O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    ASSERT_TRUE((fd > 0));
+
+    out[0] = uv_buf_init("HDR:", 4);
+    out[1] = uv_buf_init("pay\0ld", 6);
+    out[2] = uv_buf_init("ok", 2);
+    ASSERT_XEQ(12, fs_writev(fd, out, 3, 0));
+
+    in[0] = uv_buf_init(head, sizeof(head));
+    in[1] = uv_buf_init(body, sizeof(body));
+    in[2] = uv_buf_init(tail, sizeof(tail));
+    ASSERT_XEQ(12, fs_readv(fd, in, 3, 0));
+    ASSERT_EQ(0, memcmp("HDR:", head, 4));
+    ASSERT_EQ(0, memcmp("pay\0ld", body, 6));
+    ASSERT_EQ(0, memcmp("ok", tail, 2));
+    ASSERT_XEQ(UV_EINVAL, fs_readv(fd, in, 0, 0));
+
+    ASSERT_EQ(0, fs_close(fd));
+
+    /* failures come back negative, awaited as well as direct */
+    fd = fs_open("vector.file", O_RDONLY, 0);
+    ASSERT_XEQ(UV_EBADF, fs_writev(fd, out, 3, 0));
+    uv_coro_direct_set(false);
+    ASSERT_XEQ(UV_EBADF, fs_writev(fd, out, 3, 0));
+    ASSERT_XEQ(12, fs_readv(fd, in, 3, 0));
+    uv_coro_direct_set(true);
+    ASSERT_EQ(0, fs_close(fd));
+    ASSERT_XEQ(UV_EBADF, fs_writev(fd, out, 3, 0));
+
+    ASSERT_EQ(0, fs_unlink("vector.file"));
+
+    return 0;
+}
+
 TEST(fs_mkdir) {
     rid_t res = go(worker_misc, 2, 600, "mkdir");
     ASSERT_EQ(0, fs_mkdir(dir_path, 0));
@@ -129,14 +166,265 @@ TEST(fs_scandir) {
     return 0;
 }
 
+TEST(fs_reader) {
+    fs_reader_t *reader;
+    string_t chunk;
+    char data[32] = nil;
+    size_t length = 0;
+    ssize_t nread;
+    uv_file fd = fs_open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    ASSERT_TRUE((fd > 0));
+    ASSERT_EQ(9, fs_write(fd, buf, 0));
+    ASSERT_EQ(0, fs_close(fd));
+
+    ASSERT_TRUE(((fd = fs_open(path, O_RDONLY, 0)) > 0));
+    ASSERT_NOTNULL((reader = fs_reader(fd, 4)));
+    while ((nread = fs_reader_next(reader, &chunk)) > 0) {
+        ASSERT_TRUE((nread <= 4));
+        memcpy(data + length, chunk, nread);
+        length += nread;
+    }
+
+    ASSERT_EQ(0, nread);
+    ASSERT_XEQ(9, length);
+    ASSERT_STR(buf, data);
+    ASSERT_EQ(0, fs_reader_next(reader, &chunk));
+    ASSERT_EQ(0, fs_close(fd));
+    ASSERT_EQ(0, fs_unlink(path));
+
+    return 0;
+}
+
+TEST(fs_writefile_buf) {
+    ASSERT_EQ(11, fs_writefile("whole.file", "hello world"));
+    ASSERT_EQ(5, fs_writefile("whole.file", "hello"));
+    ASSERT_STR("hello", fs_readfile("whole.file"));
+
+    ASSERT_EQ(6, fs_writefile_buf("whole.file", "re\0place", 6, FS_WRITE_ATOMIC));
+    ASSERT_XEQ(6, fs_filesize("whole.file"));
+    ASSERT_EQ(0, memcmp("re\0pla", fs_readfile("whole.file"), 6));
+
+    /* replacement keeps the mode of the file it replaces */
+    ASSERT_EQ(0, fs_chmod("whole.file", 0640));
+    ASSERT_EQ(5, fs_writefile_buf("whole.file", "again", 5, FS_WRITE_ATOMIC));
+    ASSERT_EQ(0640, fs_stat("whole.file")->st_mode & 0777);
+    ASSERT_EQ(0, fs_writefile_buf("whole.file", nullptr, 0, FS_WRITE_SYNC));
+    ASSERT_STR("", fs_readfile("whole.file"));
+    ASSERT_EQ(0, fs_unlink("whole.file"));
+
+    ASSERT_NULL(fs_readfile("no_such.file"));
+    ASSERT_EQ(UV_ENOENT, fs_writefile_buf("no_such/dir.file", "x", 1, FS_WRITE_ATOMIC));
+
+    return 0;
+}
+
+TEST(fs_batch) {
+    fs_batch_t *batch = fs_batch();
+    size_t size = fs_filesize(__FILE__);
+    int stat, read, missing, written;
+
+    ASSERT_EQ(UV_EBADF, fs_batch_read(batch, FS_BATCH_FD, 16, 0));
+    stat = fs_batch_stat(batch, __FILE__);
+    read = fs_batch_readfile(batch, __FILE__, size);
+    missing = fs_batch_readfile(batch, "no_such.file", 16);
+    ASSERT_TRUE((fs_batch_open(batch, "batch.file", O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR) >= 0));
+    written = fs_batch_write(batch, FS_BATCH_FD, "hello", 5, 0);
+    ASSERT_XEQ(UV_EAGAIN, fs_batch_result(batch, read));
+    ASSERT_EQ(0, fs_batch_await(batch));
+    ASSERT_EQ(UV_EINVAL, fs_batch_await(batch));
+
+    ASSERT_XEQ(size, ((uv_stat_t *)fs_batch_data(batch, stat))->st_size);
+    ASSERT_XEQ(size, fs_batch_result(batch, read));
+    ASSERT_EQ(0, memcmp("#include", fs_batch_data(batch, read), 8));
+    ASSERT_XEQ(UV_ENOENT, fs_batch_result(batch, missing - 1));
+    ASSERT_XEQ(UV_ECANCELED, fs_batch_result(batch, missing));
+    ASSERT_NULL(fs_batch_data(batch, missing));
+    ASSERT_XEQ(5, fs_batch_result(batch, written));
+    ASSERT_STR("hello", fs_readfile("batch.file"));
+    ASSERT_EQ(0, fs_unlink("batch.file"));
+
+    return 0;
+}
+
+TEST(fs_batch_threadpool) {
+    int r;
+    uv_coro_uring_set(false);
+    r = test_fs_batch();
+    uv_coro_uring_set(true);
+
+    return r;
+}
+
+TEST(fs_batch_copied) {
+    fs_batch_t *batch = fs_batch();
+    string path = try_calloc(1, 16), data = try_calloc(1, 16);
+    int written;
+
+    /* the batch keeps its own copies, caller memory can go before it runs */
+    strcpy(path, "copied.file");
+    strcpy(data, "hello");
+    ASSERT_TRUE((fs_batch_open(batch, path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR) >= 0));
+    written = fs_batch_write(batch, FS_BATCH_FD, data, 5, 0);
+    memset(path, 'x', 15);
+    memset(data, 'x', 15);
+    RAII_FREE(path);
+    RAII_FREE(data);
+
+    ASSERT_EQ(0, fs_batch_await(batch));
+    ASSERT_XEQ(5, fs_batch_result(batch, written));
+    ASSERT_STR("hello", fs_readfile("copied.file"));
+    ASSERT_EQ(0, fs_unlink("copied.file"));
+
+    return 0;
+}
+
+TEST(fs_mmap) {
+    fs_mmap_t *map;
+    ASSERT_NOTNULL((map = fs_mmap(__FILE__, FS_MMAP_SEQUENTIAL | FS_MMAP_PREFAULT)));
+    ASSERT_XEQ(fs_filesize(__FILE__), map->length);
+    ASSERT_EQ(0, memcmp("#include", map->data, 8));
+    ASSERT_NULL(fs_mmap("no_such.file", 0));
+
+    /* mapping made after the deadline gave up is unmapped by the job, not leaked */
+    uv_coro_deadline(1);
+    map = fs_mmap(__FILE__, FS_MMAP_PREFAULT);
+    ASSERT_TRUE((!is_empty(map) || coro_err_code() == UV_ETIMEDOUT));
+    uv_coro_deadline(0);
+    sleepfor(10);
+
+    return 0;
+}
+
+TEST(fs_stat) {
+    uv_stat_t *first, *second;
+    ASSERT_NOTNULL((first = fs_stat(__FILE__)));
+    ASSERT_TRUE((first->st_size > 0));
+    ASSERT_EQ(0, fs_access(__FILE__, F_OK));
+    ASSERT_NOTNULL((second = fs_lstat(__FILE__)));
+    ASSERT_TRUE((first != second));
+    ASSERT_XEQ(first->st_size, second->st_size);
+    ASSERT_XEQ(first->st_size, fs_filesize(__FILE__));
+
+    return 0;
+}
+
+TEST(fs_deadline) {
+    uv_stat_t *stat;
+    uv_coro_deadline(5000);
+    ASSERT_NOTNULL((stat = fs_stat(__FILE__)));
+    ASSERT_TRUE((stat->st_size > 0));
+    ASSERT_NOTNULL(get_addrinfo("localhost", "http", 0));
+    uv_coro_deadline(0);
+    ASSERT_EQ(0, fs_access(__FILE__, F_OK));
+
+    return 0;
+}
+
+#if !defined(_WIN32)
+/* Opening a fifo for reading blocks a threadpool thread until a writer shows up. */
+#define FIFO_PATH "deadline.fifo"
+
+static int fifo_release(void) {
+    uv_file fd = fs_open(FIFO_PATH, O_WRONLY | O_NONBLOCK, 0);
+    if (fd < 0)
+        return fd;
+
+    fs_close(fd);
+    /* let the readers given up on complete, their descriptors get closed */
+    sleepfor(50);
+    return 0;
+}
+
+TEST(fs_deadline_expiry) {
+    ASSERT_EQ(0, mkfifo(FIFO_PATH, S_IRUSR | S_IWUSR));
+    uv_coro_deadline(50);
+    ASSERT_EQ(UV_ETIMEDOUT, fs_open(FIFO_PATH, O_RDONLY, 0));
+
+    /* the deadline holds when requests go through an awaited helper as well */
+    uv_coro_direct_set(false);
+    ASSERT_EQ(UV_ETIMEDOUT, fs_open(FIFO_PATH, O_RDONLY, 0));
+    uv_coro_direct_set(true);
+    uv_coro_deadline(0);
+
+    ASSERT_EQ(0, fifo_release());
+    ASSERT_EQ(0, fs_unlink(FIFO_PATH));
+    return 0;
+}
+
+TEST(fs_deadline_cancel) {
+    int i;
+    if (!is_empty(getenv("UV_THREADPOOL_SIZE")))
+        return 0;
+
+    /* occupy every threadpool thread, requests behind them stay queued */
+    ASSERT_EQ(0, mkfifo(FIFO_PATH, S_IRUSR | S_IWUSR));
+    uv_coro_deadline(20);
+    for (i = 0; i < 4; i++)
+        ASSERT_EQ(UV_ETIMEDOUT, fs_open(FIFO_PATH, O_RDONLY, 0));
+
+    /* queued stat is taken back off the threadpool when its deadline passes */
+    ASSERT_NULL(fs_stat(__FILE__));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+    uv_coro_deadline(0);
+
+    ASSERT_EQ(0, fifo_release());
+    ASSERT_NOTNULL(fs_stat(__FILE__));
+    ASSERT_EQ(0, fs_unlink(FIFO_PATH));
+    return 0;
+}
+
+TEST(fs_deadline_abandon) {
+    string data = try_calloc(1, 16);
+    uv_file fd;
+    int i;
+    if (!is_empty(getenv("UV_THREADPOOL_SIZE")))
+        return 0;
+
+    ASSERT_TRUE(((fd = fs_open("abandon.file", O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) > 0));
+    ASSERT_EQ(0, mkfifo(FIFO_PATH, S_IRUSR | S_IWUSR));
+    uv_coro_deadline(20);
+    for (i = 0; i < 4; i++)
+        ASSERT_EQ(UV_ETIMEDOUT, fs_open(FIFO_PATH, O_RDONLY, 0));
+
+    /* a write still queued is taken back, it never reads the caller's buffer */
+    strcpy(data, "hello");
+    ASSERT_EQ(UV_ETIMEDOUT, fs_write(fd, data, 0));
+    uv_coro_deadline(0);
+    RAII_FREE(data);
+
+    ASSERT_EQ(0, fifo_release());
+    ASSERT_NOTNULL(fs_fstat(fd));
+    ASSERT_XEQ(0, fs_fstat(fd)->st_size);
+
+    ASSERT_EQ(0, fs_close(fd));
+    ASSERT_EQ(0, fs_unlink("abandon.file"));
+    ASSERT_EQ(0, fs_unlink(FIFO_PATH));
+    return 0;
+}
+#endif
+
 TEST(list) {
     int result = 0;
 
     EXEC_TEST(fs_close);
     EXEC_TEST(fs_write_read);
+    EXEC_TEST(fs_readv_writev);
     EXEC_TEST(fs_mkdir);
     EXEC_TEST(fs_rename);
     EXEC_TEST(fs_scandir);
+    EXEC_TEST(fs_reader);
+    EXEC_TEST(fs_mmap);
+    EXEC_TEST(fs_batch);
+    EXEC_TEST(fs_batch_threadpool);
+    EXEC_TEST(fs_batch_copied);
+    EXEC_TEST(fs_writefile_buf);
+    EXEC_TEST(fs_stat);
+    EXEC_TEST(fs_deadline);
+#if !defined(_WIN32)
+    EXEC_TEST(fs_deadline_expiry);
+    EXEC_TEST(fs_deadline_cancel);
+    EXEC_TEST(fs_deadline_abandon);
+#endif
 
     return result;
 }
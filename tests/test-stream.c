@@ -40,11 +40,455 @@ TEST(stream_write) {
     return 0;
 }
 
+TEST(stream_read_into) {
+    char data[8] = nil;
+    rid_t res = go(worker_misc, 2, 600, "stream_read");
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    ASSERT_EQ(0, stream_write_buf(pair->writer, "AB\0CD", 5));
+    ASSERT_XEQ(5, stream_read_into(pair->reader, data, sizeof(data)));
+    ASSERT_EQ(0, memcmp("AB\0CD", data, 5));
+    ASSERT_FALSE(result_is_ready(res));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_TRUE(result_is_ready(res));
+    ASSERT_STR(result_for(res).char_ptr, "stream_read");
+
+    return 0;
+}
+
+TEST(stream_writev) {
+    char data[32] = nil;
+    uv_buf_t bufs[3];
+    rid_t res = go(worker_misc, 2, 600, "stream_write");
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    bufs[0] = uv_buf_init("header|", 7);
+    bufs[1] = uv_buf_init("body|", 5);
+    bufs[2] = uv_buf_init("trailer", 7);
+    ASSERT_EQ(0, stream_writev(pair->writer, bufs, 3));
+    ASSERT_XEQ(19, stream_read_into(pair->reader, data, sizeof(data)));
+    ASSERT_STR("header|body|trailer", data);
+    ASSERT_FALSE(result_is_ready(res));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_TRUE(result_is_ready(res));
+    ASSERT_STR(result_for(res).char_ptr, "stream_write");
+
+    return 0;
+}
+
+#if !defined(_WIN32)
+/* Reads `args[1]` bytes, each run of `args[2]` bytes expected as the next letter from 'a'. */
+void_t worker_drain(params_t args) {
+    uv_stream_t *reader = (uv_stream_t *)args[0].object;
+    size_t total = args[1].max_size, run = args[2].max_size, got = 0, i;
+    char data[Kb(64)];
+    ssize_t nread;
+
+    while (got < total && (nread = stream_read_into(reader, data, sizeof(data))) > 0) {
+        for (i = 0; i < (size_t)nread; i++) {
+            if (data[i] != (char)('a' + (got + i) / run))
+                return nullptr;
+        }
+
+        got += (size_t)nread;
+    }
+
+    return got == total ? "drained" : nullptr;
+}
+
+TEST(stream_try_write) {
+    socketpair_t *pair = socketpair_create(AF_UNIX, 0);
+    string data = try_calloc(1, Kb(3072));
+    uv_buf_t bufs[3], saved;
+    rid_t res;
+    uv_os_fd_t fd;
+    ASSERT_TRUE(is_socketpair(pair));
+
+    /* fits the socket buffer, done before any other coroutine gets to run */
+    res = go(worker_misc, 2, 0, "stream_write");
+    ASSERT_EQ(0, stream_write((uv_stream_t *)pair->writer, "ABCDE"));
+    ASSERT_FALSE(result_is_ready(res));
+    ASSERT_STR("ABCDE", stream_read((uv_stream_t *)pair->reader));
+
+    /* partly sent right away, the rest queued from where the kernel stopped */
+    memset(data, 'a', Kb(3072));
+    res = go(worker_drain, 3, pair->reader, (size_t)Kb(3072), (size_t)Kb(3072));
+    ASSERT_EQ(0, stream_write_buf((uv_stream_t *)pair->writer, data, Kb(3072)));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR("drained", result_for(res).char_ptr);
+
+    memset(data, 'a', Kb(1024));
+    memset(data + Kb(1024), 'b', Kb(1024));
+    memset(data + Kb(2048), 'c', Kb(1024));
+    bufs[0] = uv_buf_init(data, Kb(1024));
+    bufs[1] = uv_buf_init(data + Kb(1024), Kb(1024));
+    bufs[2] = uv_buf_init(data + Kb(2048), Kb(1024));
+    saved = bufs[1];
+    res = go(worker_drain, 3, pair->reader, (size_t)Kb(3072), (size_t)Kb(1024));
+    ASSERT_EQ(0, stream_writev((uv_stream_t *)pair->writer, bufs, 3));
+    ASSERT_TRUE((bufs[1].base == saved.base && bufs[1].len == saved.len));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR("drained", result_for(res).char_ptr);
+
+    /* hard errors come back at once, not as a queued write */
+    signal(SIGPIPE, SIG_IGN);
+    ASSERT_EQ(0, uv_fileno((uv_handle_t *)pair->writer, &fd));
+    ASSERT_EQ(0, shutdown(fd, SHUT_WR));
+    ASSERT_EQ(UV_EPIPE, stream_write((uv_stream_t *)pair->writer, "ABCDE"));
+
+    RAII_FREE(data);
+    return 0;
+}
+#endif
+
+TEST(stream_buffered) {
+    char data[8] = nil;
+    rid_t res = go(worker_misc, 2, 600, "stream_read");
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    ASSERT_EQ(0, stream_buffered(pair->reader, 0));
+    ASSERT_EQ(0, stream_write(pair->writer, "hello"));
+    ASSERT_EQ(0, stream_write(pair->writer, "world"));
+    ASSERT_XEQ(5, stream_read_into(pair->reader, data, 5));
+    ASSERT_STR("hello", data);
+    ASSERT_XEQ(5, stream_read_into(pair->reader, data, 5));
+    ASSERT_STR("world", data);
+    ASSERT_FALSE(result_is_ready(res));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_TRUE(result_is_ready(res));
+    ASSERT_STR(result_for(res).char_ptr, "stream_read");
+
+    return 0;
+}
+
+TEST(stream_cork) {
+    char data[32] = nil;
+    rid_t res = go(worker_misc, 2, 600, "stream_write");
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    ASSERT_EQ(0, stream_cork(pair->writer));
+    ASSERT_EQ(0, stream_write(pair->writer, "PING "));
+    ASSERT_EQ(0, stream_write(pair->writer, "PONG "));
+    ASSERT_EQ(0, stream_write(pair->writer, "QUIT"));
+    ASSERT_EQ(0, stream_uncork(pair->writer));
+    ASSERT_XEQ(14, stream_read_into(pair->reader, data, sizeof(data)));
+    ASSERT_STR("PING PONG QUIT", data);
+    ASSERT_FALSE(result_is_ready(res));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_TRUE(result_is_ready(res));
+    ASSERT_STR(result_for(res).char_ptr, "stream_write");
+
+    return 0;
+}
+
+TEST(stream_cork_grow) {
+    string data = try_calloc(1, Kb(32)), got = try_calloc(1, Kb(32));
+    size_t total = 0;
+    ssize_t nread;
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    memset(data, 'x', Kb(32));
+
+    /* flushed right away, leaving the buffer taken for the default threshold */
+    ASSERT_EQ(0, stream_cork(pair->writer));
+    ASSERT_EQ(0, stream_write(pair->writer, "PING"));
+    ASSERT_EQ(0, stream_uncork(pair->writer));
+    ASSERT_XEQ(4, stream_read_into(pair->reader, got, Kb(32)));
+
+    /* a raised threshold buffers more than the old buffer holds */
+    ASSERT_EQ(0, stream_autocork(pair->writer, Kb(64)));
+    ASSERT_EQ(0, stream_write_buf(pair->writer, data, Kb(32)));
+    ASSERT_EQ(0, stream_uncork(pair->writer));
+    while (total < Kb(32) && (nread = stream_read_into(pair->reader, got + total, Kb(32) - total)) > 0)
+        total += (size_t)nread;
+
+    ASSERT_XEQ(Kb(32), total);
+    ASSERT_EQ(0, memcmp(data, got, Kb(32)));
+    RAII_FREE(data);
+    RAII_FREE(got);
+
+    return 0;
+}
+
+TEST(stream_sendfile) {
+    char data[16] = nil;
+    uv_file fd;
+    socketpair_t *pair = socketpair_create(SOCK_STREAM, 0);
+    ASSERT_TRUE(is_socketpair(pair));
+    ASSERT_TRUE(((fd = fs_open(__FILE__, O_RDONLY, 0)) > 0));
+    ASSERT_XEQ(8, stream_sendfile(streamer(pair->writer), fd, 1, 8));
+    ASSERT_XEQ(8, stream_read_into(streamer(pair->reader), data, sizeof(data)));
+    ASSERT_STR("include ", data);
+    ASSERT_EQ(0, fs_close(fd));
+
+    return 0;
+}
+
+TEST(bufpool) {
+    bufpool_stats_t before, after;
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    ASSERT_EQ(0, stream_write(pair->writer, "first"));
+    ASSERT_STR("first", stream_read(pair->reader));
+    before = bufpool_stats();
+    ASSERT_EQ(0, stream_write(pair->writer, "second"));
+    ASSERT_STR("second", stream_read(pair->reader));
+    after = bufpool_stats();
+    ASSERT_TRUE((after.hits > before.hits));
+    ASSERT_UEQ(before.misses, after.misses);
+
+    return 0;
+}
+
+TEST(stream_read_timeout) {
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    ASSERT_NULL(stream_read_timeout(pair->reader, 50));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+    ASSERT_EQ(0, stream_write(pair->writer, "ABCDE"));
+    ASSERT_STR("ABCDE", stream_read_timeout(pair->reader, 1000));
+
+    uv_coro_deadline(50);
+    ASSERT_NULL(stream_read(pair->reader));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+
+    return 0;
+}
+
+TEST(stream_write_deadline) {
+    rid_t res;
+    socketpair_t *pair = socketpair_create(AF_UNIX, 0);
+    string data = try_calloc(1, Kb(4096));
+    ASSERT_TRUE(is_socketpair(pair));
+    memset(data, 'a', Kb(4096));
+
+    /* nobody reads, the write can't finish before its deadline */
+    uv_coro_deadline(50);
+    ASSERT_EQ(UV_ETIMEDOUT, stream_write_buf((uv_stream_t *)pair->writer, data, Kb(4096)));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+
+    /* only that write failed, its copy still goes out ahead of the next one */
+    uv_coro_deadline(0);
+    memset(data, 'b', Kb(1024));
+    res = go(worker_drain, 3, pair->reader, (size_t)Kb(5120), (size_t)Kb(4096));
+    ASSERT_EQ(0, stream_write_buf((uv_stream_t *)pair->writer, data, Kb(1024)));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR("drained", result_for(res).char_ptr);
+
+    pair = socketpair_create(AF_UNIX, 0);
+    memset(data, 'a', Kb(4096));
+    uv_coro_direct_set(false);
+    uv_coro_deadline(50);
+    ASSERT_EQ(UV_ETIMEDOUT, stream_write_buf((uv_stream_t *)pair->writer, data, Kb(4096)));
+    uv_coro_direct_set(true);
+    uv_coro_deadline(0);
+    memset(data, 'b', Kb(1024));
+    res = go(worker_drain, 3, pair->reader, (size_t)Kb(5120), (size_t)Kb(4096));
+    ASSERT_EQ(0, stream_write_buf((uv_stream_t *)pair->writer, data, Kb(1024)));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR("drained", result_for(res).char_ptr);
+
+    /* a read finishing early leaves the next one its own expiry */
+    pair = socketpair_create(AF_UNIX, 0);
+    uv_coro_deadline(100);
+    ASSERT_EQ(0, stream_write((uv_stream_t *)pair->writer, "ABCDE"));
+    ASSERT_STR("ABCDE", stream_read((uv_stream_t *)pair->reader));
+    ASSERT_NULL(stream_read((uv_stream_t *)pair->reader));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+    uv_coro_deadline(0);
+
+    RAII_FREE(data);
+    return 0;
+}
+
+TEST(uv_coro_run_set) {
+    rid_t res;
+    pipepair_t *pair = pipepair_create(false);
+    ASSERT_TRUE(is_pipepair(pair));
+    uv_coro_run_set(UV_CORO_RUN_ADAPTIVE, 8, 5);
+    res = go(worker_misc, 2, 100, "stream_read");
+    ASSERT_EQ(0, stream_write(pair->writer, "ABCDE"));
+    ASSERT_STR("ABCDE", stream_read(pair->reader));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR(result_for(res).char_ptr, "stream_read");
+    ASSERT_EQ(UV_EINVAL, uv_coro_run_set(UV_CORO_RUN_BLOCK, 0, 0));
+    ASSERT_EQ(0, uv_coro_run_set(UV_CORO_RUN_BLOCK, 0, 100));
+    ASSERT_EQ(0, stream_write(pair->writer, "FGHIJ"));
+    ASSERT_STR("FGHIJ", stream_read(pair->reader));
+    uv_coro_run_set(UV_CORO_RUN_NOWAIT, 0, 0);
+
+    return 0;
+}
+
+static uint64_t cpu_usec(void) {
+    uv_rusage_t usage;
+    uv_getrusage(&usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+        + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+void_t worker_compute(params_t args) {
+    int i;
+    for (i = 0; i < args[0].integer; i++)
+        yield();
+
+    return "computed";
+}
+
+TEST(uv_coro_run_block) {
+    uint64_t cpu, wall;
+    rid_t res;
+
+    /* sleeping with nothing else to do leaves the thread idle in the loop */
+    ASSERT_EQ(0, uv_coro_run_set(UV_CORO_RUN_BLOCK, 0, 100));
+    wall = uv_hrtime();
+    cpu = cpu_usec();
+    sleepfor(200);
+    cpu = cpu_usec() - cpu;
+    wall = (uv_hrtime() - wall) / 1000;
+    ASSERT_TRUE((cpu < wall / 2));
+
+    /* a bounded block only slows a compute coroutine down, never parks it for good */
+    uv_coro_run_set(UV_CORO_RUN_BLOCK, 0, 2);
+    res = go(worker_compute, 1, (void_t)50);
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR(result_for(res).char_ptr, "computed");
+    uv_coro_run_set(UV_CORO_RUN_NOWAIT, 0, 0);
+
+    return 0;
+}
+
+static int slept[6], slept_count = 0;
+
+void_t worker_sleeper(params_t args) {
+    uint64_t start = uv_hrtime();
+    sleepfor(args[0].u_int);
+    slept[slept_count++] = (int)args[0].u_int;
+
+    return (void_t)((uv_hrtime() - start) / 1000000);
+}
+
+TEST(sleepfor_order) {
+    /* across the first wheel level, its 64ms wraparound, and a cascade from the next */
+    u32 ms[6] = {200, 1, 68, 130, 30, 60};
+    u32 sorted[6] = {1, 30, 60, 68, 130, 200};
+    rid_t res[6];
+    int i;
+    slept_count = 0;
+    for (i = 0; i < 6; i++)
+        res[i] = go(worker_sleeper, 1, (void_t)(uintptr_t)ms[i]);
+
+    for (i = 0; i < 6; i++) {
+        while (!result_is_ready(res[i]))
+            yield();
+
+        ASSERT_TRUE((result_for(res[i]).ulong_long + 1 >= ms[i]));
+        ASSERT_TRUE((result_for(res[i]).ulong_long < ms[i] + 250));
+    }
+
+    ASSERT_EQ(6, slept_count);
+    for (i = 0; i < 6; i++)
+        ASSERT_EQ(sorted[i], slept[i]);
+
+    return 0;
+}
+
+TEST(sleepfor_revolution) {
+    uint64_t start;
+    rid_t res;
+    int i;
+
+    /* back to back sleeps keep landing on slots past the wrap of the first level */
+    for (i = 0; i < 4; i++) {
+        start = uv_hrtime();
+        sleepfor(40);
+        ASSERT_TRUE(((uv_hrtime() - start) / 1000000 + 1 >= 40));
+    }
+
+    /* longer than a full turn of the first two levels, cascades down from the third */
+    slept_count = 0;
+    res = go(worker_sleeper, 1, (void_t)4200);
+    sleepfor(100);
+    ASSERT_FALSE(result_is_ready(res));
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_TRUE((result_for(res).ulong_long + 1 >= 4200));
+    ASSERT_TRUE((result_for(res).ulong_long < 4200 + 250));
+    ASSERT_EQ(1, slept_count);
+
+    return 0;
+}
+
+TEST(stream_select) {
+    stream_selected_t *ready;
+    pipepair_t *first = pipepair_create(false);
+    pipepair_t *second = pipepair_create(false);
+    void_t handles[2];
+    ASSERT_TRUE(is_pipepair(first));
+    ASSERT_TRUE(is_pipepair(second));
+    handles[0] = first->reader;
+    handles[1] = second->reader;
+
+    ASSERT_EQ(0, stream_write(second->writer, "ABCDE"));
+    ASSERT_NOTNULL((ready = stream_select(handles, 2, 1000)));
+    ASSERT_EQ(1, ready->index);
+    ASSERT_XEQ(5, ready->nread);
+    ASSERT_STR("ABCDE", ready->data);
+
+    ASSERT_EQ(0, stream_write(first->writer, "FGHIJ"));
+    ASSERT_NOTNULL((ready = stream_select(handles, 2, 1000)));
+    ASSERT_EQ(0, ready->index);
+    ASSERT_STR("FGHIJ", ready->data);
+
+    ASSERT_NULL(stream_select(handles, 2, 50));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+
+    return 0;
+}
+
 TEST(list) {
     int result = 0;
 
     EXEC_TEST(stream_read);
     EXEC_TEST(stream_write);
+    EXEC_TEST(stream_read_into);
+    EXEC_TEST(stream_read_timeout);
+    EXEC_TEST(stream_write_deadline);
+    EXEC_TEST(stream_select);
+    EXEC_TEST(stream_writev);
+#if !defined(_WIN32)
+    EXEC_TEST(stream_try_write);
+#endif
+    EXEC_TEST(stream_buffered);
+    EXEC_TEST(stream_cork);
+    EXEC_TEST(stream_cork_grow);
+    EXEC_TEST(stream_sendfile);
+    EXEC_TEST(bufpool);
+    EXEC_TEST(uv_coro_run_set);
+    EXEC_TEST(uv_coro_run_block);
+    EXEC_TEST(sleepfor_order);
+    EXEC_TEST(sleepfor_revolution);
 
     return result;
 }
@@ -46,10 +46,237 @@ TEST(stream_listen) {
     return 0;
 }
 
+void_t worker_burst(params_t args) {
+    uv_stream_t *server = nullptr;
+    ASSERT_WORKER(is_tcp(server = stream_connect("http://127.0.0.1:8091")));
+    ASSERT_WORKER((stream_write(server, "hello") == 0));
+    ASSERT_WORKER(is_str_eq("world", stream_read(server)));
+
+    return args[0].char_ptr;
+}
+
+TEST(stream_accept_all) {
+    uv_stream_t *socket;
+    int count = 0, i;
+    rid_t res[3];
+    ASSERT_TRUE(is_tcp(socket = stream_bind("0.0.0.0:8091", 0)));
+    for (i = 0; i < 3; i++)
+        res[i] = go(worker_burst, 1, "burst");
+
+    while (count < 3) {
+        ASSERT_TRUE(((i = stream_accept_all(socket, 128, (stream_cb)worker_connected)) > 0));
+        count += i;
+    }
+
+    ASSERT_EQ(3, count);
+    ASSERT_NULL(stream_accepted(socket));
+    for (i = 0; i < 3; i++) {
+        while (!result_is_ready(res[i]))
+            yield();
+
+        ASSERT_STR(result_for(res[i]).char_ptr, "burst");
+    }
+
+    return 0;
+}
+
+void_t worker_handler(params_t args) {
+    uv_stream_t *server = nullptr;
+    ASSERT_WORKER(is_tcp(server = stream_connect(args[0].char_ptr)));
+    ASSERT_WORKER((stream_write(server, "hello") == 0));
+    ASSERT_WORKER(is_str_eq("world", stream_read(server)));
+
+    return args[1].char_ptr;
+}
+
+static int handler_id = 0, clients_released = 0;
+static void client_released(void_t data) {
+    clients_released++;
+}
+
+void_t worker_recycled(uv_stream_t *socket) {
+    raii_deferred(uv_coro_scope(), client_released, nullptr);
+    ASSERT_WORKER(is_str_eq("hello", stream_read(socket)));
+    ASSERT_WORKER((stream_write(socket, "world") == 0));
+    handler_id = coro_active_id();
+    return 0;
+}
+
+TEST(stream_handler_ex) {
+    uv_stream_t *client, *socket;
+    int first;
+    rid_t res = go(worker_handler, 2, "http://127.0.0.1:8092", "small stack");
+
+    ASSERT_TRUE(is_tcp(socket = stream_bind("0.0.0.0:8092", 0)));
+    ASSERT_TRUE(is_tcp(client = stream_listen(socket, 128)));
+    stream_handler_ex((stream_cb)worker_recycled, client, Kb(20));
+    while (!result_is_ready(res) || !clients_released)
+        yield();
+
+    ASSERT_STR(result_for(res).char_ptr, "small stack");
+
+    /* the next client of the same class runs on the parked coroutine, and its stack */
+    first = handler_id;
+    handler_id = 0;
+    res = go(worker_handler, 2, "http://127.0.0.1:8092", "same stack");
+    ASSERT_TRUE(is_tcp(client = stream_listen(socket, 128)));
+    stream_handler_ex((stream_cb)worker_recycled, client, Kb(32));
+    while (!result_is_ready(res) || clients_released < 2)
+        yield();
+
+    /* each client's scope is released as its handler returns, not when the coroutine ends */
+    ASSERT_STR(result_for(res).char_ptr, "same stack");
+    ASSERT_EQ(first, handler_id);
+
+    /* past the largest class, taken as given */
+    res = go(worker_handler, 2, "http://127.0.0.1:8092", "large stack");
+    ASSERT_TRUE(is_tcp(client = stream_listen(socket, 128)));
+    stream_handler_ex((stream_cb)worker_recycled, client, Kb(8192) + 1);
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR(result_for(res).char_ptr, "large stack");
+
+    return 0;
+}
+
+TEST(uv_coro_pool) {
+    uv_stream_t *socket;
+    int count = 0, i;
+    rid_t res[4];
+    ASSERT_EQ(0, uv_coro_pool(2, 1));
+    ASSERT_EQ(UV_EBUSY, uv_coro_pool(4, 0));
+    ASSERT_TRUE(is_tcp(socket = stream_bind("0.0.0.0:8093", 0)));
+    for (i = 0; i < 4; i++)
+        res[i] = go(worker_handler, 2, "http://127.0.0.1:8093", "pooled");
+
+    while (count < 4) {
+        ASSERT_TRUE(((i = stream_accept_all(socket, 128, (stream_cb)worker_connected)) > 0));
+        count += i;
+    }
+
+    for (i = 0; i < 4; i++) {
+        while (!result_is_ready(res[i]))
+            yield();
+
+        ASSERT_STR(result_for(res[i]).char_ptr, "pooled");
+    }
+
+    ASSERT_EQ(0, uv_coro_pool(0, 0));
+
+    return 0;
+}
+
+TEST(uv_coro_pool_close) {
+    uv_stream_t *socket;
+    int count = 0, i;
+    rid_t res[3];
+    ASSERT_EQ(0, uv_coro_pool(1, 4));
+    ASSERT_TRUE(is_tcp(socket = stream_bind("0.0.0.0:8094", 0)));
+    for (i = 0; i < 3; i++)
+        res[i] = go(worker_handler, 2, "http://127.0.0.1:8094", "drained");
+
+    while (count < 3) {
+        ASSERT_TRUE(((i = stream_accept_all(socket, 128, (stream_cb)worker_connected)) > 0));
+        count += i;
+    }
+
+    /* clients still queued are served by coroutines of their own */
+    ASSERT_EQ(0, uv_coro_pool(0, 0));
+    for (i = 0; i < 3; i++) {
+        while (!result_is_ready(res[i]))
+            yield();
+
+        ASSERT_STR(result_for(res[i]).char_ptr, "drained");
+    }
+
+    return 0;
+}
+
+static uv_mutex_t cluster_lock;
+static uv_thread_t cluster_caller;
+static int cluster_served = 0, cluster_elsewhere = 0;
+
+void_t worker_clustered(uv_stream_t *socket) {
+    uv_thread_t self = uv_thread_self();
+    ASSERT_WORKER(is_str_eq("hello", stream_read(socket)));
+    ASSERT_WORKER((stream_write(socket, "world") == 0));
+
+    uv_mutex_lock(&cluster_lock);
+    cluster_served++;
+    if (!uv_thread_equal(&self, &cluster_caller))
+        cluster_elsewhere++;
+    uv_mutex_unlock(&cluster_lock);
+    return 0;
+}
+
+void_t worker_cluster(params_t args) {
+    /* this coroutine serves the first listener, only reached once its `stream_listen()` returned */
+    if (stream_bind_cluster(args[0].char_ptr, 2, (stream_cb)worker_clustered) == 0)
+        return "stopped";
+
+    return nullptr;
+}
+
+TEST(stream_bind_cluster) {
+    int served = 0, elsewhere = 0, i;
+    rid_t cluster, res[16];
+    uv_mutex_init(&cluster_lock);
+    cluster_caller = uv_thread_self();
+    ASSERT_EQ(UV_EINVAL, stream_cluster_stop());
+    cluster = go(worker_cluster, 1, "0.0.0.0:8095");
+    sleepfor(200);
+    for (i = 0; i < 16; i++)
+        res[i] = go(worker_handler, 2, "http://127.0.0.1:8095", "clustered");
+
+    for (i = 0; i < 16; i++) {
+        while (!result_is_ready(res[i]))
+            yield();
+
+        ASSERT_STR(result_for(res[i]).char_ptr, "clustered");
+    }
+
+    while (served < 16) {
+        yield();
+        uv_mutex_lock(&cluster_lock);
+        served = cluster_served;
+        elsewhere = cluster_elsewhere;
+        uv_mutex_unlock(&cluster_lock);
+    }
+
+    /* `SO_REUSEPORT` spreads clients over both listeners, the calling one and its thread */
+    ASSERT_TRUE((elsewhere > 0 && elsewhere < 16));
+    ASSERT_EQ(0, stream_cluster_stop());
+    while (!result_is_ready(cluster))
+        yield();
+
+    ASSERT_STR("stopped", result_for(cluster).char_ptr);
+    ASSERT_EQ(UV_EINVAL, stream_cluster_stop());
+
+    /* listeners parked in `stream_listen()` with no client yet return too */
+    cluster = go(worker_cluster, 1, "0.0.0.0:8095");
+    sleepfor(200);
+    ASSERT_EQ(0, stream_cluster_stop());
+    while (!result_is_ready(cluster))
+        yield();
+
+    ASSERT_STR("stopped", result_for(cluster).char_ptr);
+    uv_mutex_destroy(&cluster_lock);
+
+    return 0;
+}
+
 TEST(list) {
     int result = 0;
 
     EXEC_TEST(stream_listen);
+    EXEC_TEST(stream_accept_all);
+    EXEC_TEST(stream_handler_ex);
+    EXEC_TEST(uv_coro_pool);
+    EXEC_TEST(uv_coro_pool_close);
+#if UV_VERSION_HEX >= 0x013100
+    EXEC_TEST(stream_bind_cluster);
+#endif
 
     return result;
 }
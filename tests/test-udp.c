@@ -50,10 +50,66 @@ TEST(udp_listen) {
     return 0;
 }
 
+TEST(udp_recv_deadline) {
+    uv_udp_t *client;
+    ASSERT_TRUE(is_udp(client = udp_bind("127.0.0.1:7779", 0)));
+    uv_coro_deadline(50);
+    ASSERT_NULL(udp_recv(client));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+
+    /* each receive arms an expiry of its own */
+    uv_coro_deadline(50);
+    ASSERT_NULL(udp_recv(client));
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+    uv_coro_deadline(0);
+
+    return 0;
+}
+
+void_t worker_selector(params_t args) {
+    void_t handles[1];
+    handles[0] = args[0].object;
+    ASSERT_WORKER(is_empty(stream_select(handles, 1, 50)));
+    ASSERT_WORKER((coro_err_code() == UV_ETIMEDOUT));
+
+    return "selected";
+}
+
+TEST(udp_select) {
+    uv_udp_t *handle, *sender;
+    struct sockaddr_in addr;
+    stream_selected_t *ready;
+    void_t handles[1];
+    rid_t res;
+    ASSERT_TRUE(is_udp(handle = udp_create()));
+    ASSERT_EQ(0, uv_ip4_addr("127.0.0.1", 7781, &addr));
+    ASSERT_EQ(0, uv_udp_bind(handle, (const struct sockaddr *)&addr, 0));
+
+    /* arguments select set up leave with the selecting coroutine, not the handle */
+    res = go(worker_selector, 1, handle);
+    while (!result_is_ready(res))
+        yield();
+
+    ASSERT_STR(result_for(res).char_ptr, "selected");
+    ASSERT_NULL(uv_handle_get_data((uv_handle_t *)handle));
+
+    ASSERT_TRUE(is_udp(sender = udp_bind("127.0.0.1:7782", 0)));
+    ASSERT_EQ(0, udp_send(sender, "hello", "udp://127.0.0.1:7781"));
+    handles[0] = handle;
+    ASSERT_NOTNULL((ready = stream_select(handles, 1, 1000)));
+    ASSERT_EQ(0, ready->index);
+    ASSERT_STR("hello", udp_get_message(ready->packet));
+    ASSERT_NULL(uv_handle_get_data((uv_handle_t *)handle));
+
+    return 0;
+}
+
 TEST(list) {
     int result = 0;
 
     EXEC_TEST(udp_listen);
+    EXEC_TEST(udp_recv_deadline);
+    EXEC_TEST(udp_select);
 
     return result;
 }
@@ -0,0 +1,82 @@
+#include "assertions.h"
+
+void_t worker_sum(params_t args) {
+    size_t i, total = 0;
+    for (i = 0; i <= args[0].ulong_long; i++)
+        total += i;
+
+    return (void_t)total;
+}
+
+void_t worker_slow(params_t args) {
+    uv_sleep((unsigned int)args[0].ulong_long);
+    return args[1].object;
+}
+
+TEST(queue_work) {
+    ASSERT_XEQ(5050, queue_work(worker_sum, 1, (void_t)100).ulong_long);
+    ASSERT_XEQ(500500, queue_work(worker_sum, 1, (void_t)1000).ulong_long);
+    ASSERT_NULL(queue_work(nullptr, 0).object);
+
+    return 0;
+}
+
+TEST(queue_work_deadline) {
+    uint64_t start = uv_now(uv_coro_loop());
+    uv_coro_deadline(50);
+    ASSERT_NULL(queue_work(worker_slow, 2, (void_t)500, "late").object);
+    ASSERT_EQ(UV_ETIMEDOUT, coro_err_code());
+    ASSERT_TRUE((uv_now(uv_coro_loop()) - start < 500));
+    uv_coro_deadline(0);
+
+    /* abandoned job still owns its arguments, next one runs normally */
+    ASSERT_STR("done", queue_work(worker_slow, 2, (void_t)10, "done").char_ptr);
+
+    return 0;
+}
+
+static uv_mutex_t tasks_lock;
+static int tasks_done = 0;
+
+void_t worker_task(params_t args) {
+    uv_mutex_lock(&tasks_lock);
+    tasks_done += (int)args[0].integer;
+    uv_mutex_unlock(&tasks_lock);
+    return 0;
+}
+
+TEST(uv_coro_workers) {
+    int i;
+    uv_mutex_init(&tasks_lock);
+    ASSERT_EQ(UV_ENOTSUP, uv_coro_task(worker_task, 1, (void_t)1));
+    ASSERT_EQ(0, uv_coro_workers(2));
+    ASSERT_EQ(UV_EBUSY, uv_coro_workers(2));
+    for (i = 0; i < 8; i++)
+        ASSERT_EQ(0, uv_coro_task(worker_task, 1, (void_t)1));
+
+    ASSERT_EQ(0, uv_coro_workers_stop());
+    ASSERT_EQ(8, tasks_done);
+
+    /* started again, the thread key is kept across runs */
+    ASSERT_EQ(0, uv_coro_workers(1));
+    ASSERT_EQ(0, uv_coro_task(worker_task, 1, (void_t)1));
+    ASSERT_EQ(0, uv_coro_workers_stop());
+    ASSERT_EQ(9, tasks_done);
+    uv_mutex_destroy(&tasks_lock);
+
+    return 0;
+}
+
+TEST(list) {
+    int result = 0;
+
+    EXEC_TEST(queue_work);
+    EXEC_TEST(queue_work_deadline);
+    EXEC_TEST(uv_coro_workers);
+
+    return result;
+}
+
+int uv_main(int argc, char **argv) {
+    TEST_FUNC(list());
+}